@@ -0,0 +1,155 @@
+#include "alloc_track.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+static SDL_atomic_t heapAllocs, heapFrees, resourcesCreated, resourcesDestroyed;
+
+// The allocator SDL had before tracking started; everything is passed on.
+static SDL_malloc_func realMalloc;
+static SDL_calloc_func realCalloc;
+static SDL_realloc_func realRealloc;
+static SDL_free_func realFree;
+
+static void* countedMalloc(size_t size) {
+    SDL_AtomicAdd(&heapAllocs, 1);
+    return realMalloc(size);
+}
+
+static void* countedCalloc(size_t nmemb, size_t size) {
+    SDL_AtomicAdd(&heapAllocs, 1);
+    return realCalloc(nmemb, size);
+}
+
+static void* countedRealloc(void* mem, size_t size) {
+    SDL_AtomicAdd(&heapAllocs, 1);
+    return realRealloc(mem, size);
+}
+
+static void countedFree(void* mem) {
+    if (mem != NULL)
+        SDL_AtomicAdd(&heapFrees, 1);
+    realFree(mem);
+}
+
+void startAllocTracking(void) {
+    SDL_GetMemoryFunctions(&realMalloc, &realCalloc, &realRealloc, &realFree);
+    if (SDL_SetMemoryFunctions(countedMalloc, countedCalloc, countedRealloc, countedFree) < 0)
+        printf("Could not hook SDL's allocator: %s\n", SDL_GetError());
+}
+
+AllocCounts readAllocCounts(void) {
+    AllocCounts counts;
+    counts.heapAllocs = SDL_AtomicGet(&heapAllocs);
+    counts.heapFrees = SDL_AtomicGet(&heapFrees);
+    counts.resourcesCreated = SDL_AtomicGet(&resourcesCreated);
+    counts.resourcesDestroyed = SDL_AtomicGet(&resourcesDestroyed);
+    return counts;
+}
+
+void* operator new(size_t size) {
+    SDL_AtomicAdd(&heapAllocs, 1);
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p != NULL)
+        SDL_AtomicAdd(&heapFrees, 1);
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+SDL_Texture* trackedCreateTextureFromSurface(SDL_Renderer* renderer, SDL_Surface* surface) {
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture)
+        SDL_AtomicAdd(&resourcesCreated, 1);
+    return texture;
+}
+
+SDL_Texture* trackedCreateTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, w, h);
+    if (texture)
+        SDL_AtomicAdd(&resourcesCreated, 1);
+    return texture;
+}
+
+void trackedDestroyTexture(SDL_Texture* texture) {
+    if (texture)
+        SDL_AtomicAdd(&resourcesDestroyed, 1);
+    SDL_DestroyTexture(texture);
+}
+
+SDL_Surface* trackedCreateSurface(int w, int h) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface)
+        SDL_AtomicAdd(&resourcesCreated, 1);
+    return surface;
+}
+
+SDL_Surface* trackedLoadImage(const char* file) {
+    SDL_Surface* surface = IMG_Load(file);
+    if (surface)
+        SDL_AtomicAdd(&resourcesCreated, 1);
+    return surface;
+}
+
+void trackedFreeSurface(SDL_Surface* surface) {
+    if (surface)
+        SDL_AtomicAdd(&resourcesDestroyed, 1);
+    SDL_FreeSurface(surface);
+}
+
+void resetFrameAllocs(FrameAllocStats* stats) {
+    stats->frames = 0;
+    stats->checkedFrames = 0;
+    stats->failedFrames = 0;
+    stats->windowStart = SDL_GetTicks();
+    stats->windowFrames = 0;
+    stats->windowAllocs = 0;
+    stats->windowResources = 0;
+}
+
+void beginFrameAllocs(FrameAllocStats* stats) {
+    stats->frameStart = readAllocCounts();
+}
+
+void endFrameAllocs(FrameAllocStats* stats) {
+    AllocCounts now = readAllocCounts();
+    int allocs = now.heapAllocs - stats->frameStart.heapAllocs;
+    int resources = now.resourcesCreated - stats->frameStart.resourcesCreated;
+    stats->frames++;
+    if (stats->frames > ALLOC_WARMUP_FRAMES) {
+        stats->checkedFrames++;
+        if (allocs > 0 || resources > 0) {
+            stats->failedFrames++;
+            printf("Frame %d: %d heap allocations, %d SDL resources created\n", stats->frames, allocs, resources);
+        }
+    }
+    stats->windowFrames++;
+    stats->windowAllocs += allocs;
+    stats->windowResources += resources;
+    Uint32 ticks = SDL_GetTicks();
+    if (ticks - stats->windowStart >= 1000) {
+        printf("Frame stats: %d frames, %.2f heap allocations and %.2f SDL resources per frame\n", stats->windowFrames,
+               (float)stats->windowAllocs / stats->windowFrames, (float)stats->windowResources / stats->windowFrames);
+        stats->windowStart = ticks;
+        stats->windowFrames = 0;
+        stats->windowAllocs = 0;
+        stats->windowResources = 0;
+    }
+}
+
+bool checkFrameAllocs(const FrameAllocStats* stats) {
+    if (stats->failedFrames == 0) {
+        printf("Allocation check passed: %d frames after warm-up made no allocations\n", stats->checkedFrames);
+        return true;
+    }
+    printf("Allocation check FAILED: %d of %d frames after warm-up allocated\n", stats->failedFrames, stats->checkedFrames);
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef ALLOC_TRACK_H
+#define ALLOC_TRACK_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdbool.h>
+
+// Counts heap allocations and SDL resource creation, to check that a
+// steady-state frame allocates nothing. operator new and delete are always
+// counted. SDL's heap, which SDL_image and SDL_mixer share, is
+// counted once startAllocTracking has run. Textures and surfaces are
+// counted through the wrappers below, which the game uses in place of the
+// SDL calls.
+//
+// Plain malloc, calloc and realloc are not counted in the game. "make
+// check" catches those: tools/alloccheck.cpp links with the C allocator
+// wrapped and fails if a gameplay frame calls it after warm-up.
+
+// Frames at the start of a round that may still allocate (renderer
+// buffers growing, first uses of a code path).
+#define ALLOC_WARMUP_FRAMES 60
+
+typedef struct {
+    int heapAllocs;           // operator new and SDL_malloc/calloc/realloc.
+    int heapFrees;
+    int resourcesCreated;     // Textures and surfaces.
+    int resourcesDestroyed;
+} AllocCounts;
+
+// Routes SDL's allocator through the counters. Call before SDL_Init.
+void startAllocTracking(void);
+
+AllocCounts readAllocCounts(void);
+
+SDL_Texture* trackedCreateTextureFromSurface(SDL_Renderer* renderer, SDL_Surface* surface);
+SDL_Texture* trackedCreateTexture(SDL_Renderer* renderer, Uint32 format, int access, int w, int h);
+void trackedDestroyTexture(SDL_Texture* texture);
+SDL_Surface* trackedCreateSurface(int w, int h);  // ARGB8888
+SDL_Surface* trackedLoadImage(const char* file);
+void trackedFreeSurface(SDL_Surface* surface);
+
+// Per-frame allocation statistics for the gameplay loop.
+typedef struct {
+    AllocCounts frameStart;
+    int frames;               // Since the round started.
+    int checkedFrames;        // After warm-up.
+    int failedFrames;         // After warm-up, and allocated something.
+    Uint32 windowStart;       // Ticks when the current one-second report began.
+    int windowFrames;
+    int windowAllocs;
+    int windowResources;
+} FrameAllocStats;
+
+void resetFrameAllocs(FrameAllocStats* stats);
+void beginFrameAllocs(FrameAllocStats* stats);
+
+// Closes the frame's count and prints a line each second. A frame past
+// warm-up that allocated is reported on its own.
+void endFrameAllocs(FrameAllocStats* stats);
+
+// Prints whether every frame past warm-up made no allocations, and returns
+// that.
+bool checkFrameAllocs(const FrameAllocStats* stats);
+
+#endif // ALLOC_TRACK_H
@@ -0,0 +1,81 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Heads each overflow block; the memory handed out follows it.
+struct ArenaOverflow {
+    ArenaOverflow* next;
+};
+
+static size_t alignUp(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+bool initArena(Arena* arena, size_t size) {
+    memset(arena, 0, sizeof(Arena));
+    arena->base = (Uint8*)malloc(size);
+    if (arena->base == NULL) {
+        printf("Error allocating a %zu byte arena\n", size);
+        return false;
+    }
+    arena->size = size;
+    return true;
+}
+
+static void* overflowAlloc(Arena* arena, size_t size, size_t align) {
+    size_t head = alignUp(sizeof(ArenaOverflow), align);
+    ArenaOverflow* block = (ArenaOverflow*)malloc(head + size + align);
+    if (block == NULL)
+        return NULL;
+    if (arena->overflow == NULL)
+        printf("Round arena full (%zu bytes); raise SESSION_ARENA_BYTES\n", arena->size);
+    block->next = arena->overflow;
+    arena->overflow = block;
+    arena->overflowBytes += size;
+    return (void*)alignUp((size_t)((Uint8*)block + head), align);
+}
+
+void* arenaAllocAligned(Arena* arena, size_t size, size_t align) {
+    if (arena == NULL)
+        return malloc(size > 0 ? size : 1);
+    size_t offset = alignUp((size_t)(arena->base + arena->used), align) - (size_t)arena->base;
+    void* memory;
+    if (arena->base != NULL && offset + size <= arena->size) {
+        memory = arena->base + offset;
+        arena->used = offset + size;
+    } else {
+        memory = overflowAlloc(arena, size, align);
+    }
+    if (arena->used + arena->overflowBytes > arena->peak)
+        arena->peak = arena->used + arena->overflowBytes;
+    return memory;
+}
+
+void* arenaCalloc(Arena* arena, size_t size) {
+    void* memory = arenaAlloc(arena, size);
+    if (memory != NULL)
+        memset(memory, 0, size);
+    return memory;
+}
+
+void arenaFree(Arena* arena, void* memory) {
+    if (arena == NULL)
+        free(memory);
+}
+
+void resetArena(Arena* arena) {
+    while (arena->overflow != NULL) {
+        ArenaOverflow* next = arena->overflow->next;
+        free(arena->overflow);
+        arena->overflow = next;
+    }
+    arena->used = 0;
+    arena->overflowBytes = 0;
+}
+
+void freeArena(Arena* arena) {
+    resetArena(arena);
+    free(arena->base);
+    memset(arena, 0, sizeof(Arena));
+}
@@ -0,0 +1,89 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <SDL.h>
+#include <memory_resource>
+#include <new>
+#include <stdbool.h>
+#include <stddef.h>
+
+// A bump allocator for data that lives exactly one round: the level, the
+// mine's tables and the soft raster's background. Allocating is a pointer
+// bump, freeing is a no-op, and the round ends with one resetArena, so
+// rounds come and go over days without scattering anything across the
+// heap. An arena is used by one thread at a time.
+//
+// What does not fit goes on the heap and is given back at the reset; the
+// first overflow of a round is reported, and peak counts it, so the size
+// can be raised to match.
+//
+// Everything that takes an Arena* also takes NULL, meaning the plain heap,
+// for the tools and anything else that does not work in rounds.
+
+// Per arena. The soft raster's 1366x768 background is 4 MB of it; without
+// that a round needs well under 1 MB, and untouched pages cost nothing.
+#define SESSION_ARENA_BYTES (8 * 1024 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct ArenaOverflow ArenaOverflow;
+
+typedef struct {
+    Uint8* base;
+    size_t size;
+    size_t used;
+    size_t overflowBytes;     // On the heap this round.
+    ArenaOverflow* overflow;
+    size_t peak;              // Most ever in use in one round, overflow included.
+} Arena;
+
+bool initArena(Arena* arena, size_t size);
+
+// Aligned to `align`, a power of two; from a NULL arena this is malloc, so
+// no more than ARENA_ALIGN. Returns NULL only when the heap is out of
+// memory.
+void* arenaAllocAligned(Arena* arena, size_t size, size_t align);
+
+inline void* arenaAlloc(Arena* arena, size_t size) {
+    return arenaAllocAligned(arena, size, ARENA_ALIGN);
+}
+
+// Zeroed, like calloc.
+void* arenaCalloc(Arena* arena, size_t size);
+
+// Frees heap memory from a NULL arena; memory in an arena waits for the reset.
+void arenaFree(Arena* arena, void* memory);
+
+// Gives back everything allocated since the last reset.
+void resetArena(Arena* arena);
+
+void freeArena(Arena* arena);
+
+// The same arena as a std::pmr::memory_resource, for standard containers;
+// tools/arenacheck.cpp runs it under "make check".
+// Defined here so that the level tools, which link no SDL, never pull in the
+// tracked operator delete its vtable would need.
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    explicit ArenaResource(Arena* arena) : arena(arena) {}
+
+private:
+    Arena* arena;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* memory = arenaAllocAligned(arena, bytes, alignment);
+        if (memory == NULL)
+            throw std::bad_alloc();
+        return memory;
+    }
+
+    void do_deallocate(void* p, size_t, size_t) override {
+        arenaFree(arena, p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        const ArenaResource* o = dynamic_cast<const ArenaResource*>(&other);
+        return o != NULL && o->arena == arena;
+    }
+};
+
+#endif // ARENA_H
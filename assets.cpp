@@ -0,0 +1,116 @@
+#include "assets.h"
+#include <stdio.h>
+#include <string.h>
+#include "alloc_track.h"
+#include "game.h"
+#include "sfx.h"
+
+static const char* TEXTURE_FILES[TEX_OBJECTS] = {
+    "character.png", "hook.png", "dynamite.png", "explosion.png", "success.png", "failure.png", "Target.png",
+};
+
+static const char* textureFile(int i) {
+    return i < TEX_OBJECTS ? TEXTURE_FILES[i] : OBJECT_SPRITE_FILES[i - TEX_OBJECTS];
+}
+
+static int assetsWorker(void* data) {
+    GameAssets* assets = (GameAssets*)data;
+    // Opening the audio device can take a good part of a second on some
+    // systems. Without it the game runs on silently.
+    if (openSfxAudio(assets->audioBuffer)) {
+        loadSfx();
+        assets->targetMusic = Mix_LoadMUS("target.mp3");
+        if (!assets->targetMusic)
+            printf("Error loading target.mp3: %s\n", Mix_GetError());
+    }
+    for (int i = 0; i < NUM_GAME_TEXTURES; i++) {
+        assets->surfaces[i] = trackedLoadImage(textureFile(i));
+        if (!assets->surfaces[i])
+            printf("Error loading %s: %s\n", textureFile(i), IMG_GetError());
+    }
+    int hookW, hookH;
+    SDL_Point pivot;
+    hookGeometry(&hookW, &hookH, &pivot);
+    buildRotatedSprite(&assets->hookSprites[HOOK_SPRITE_HOOK], assets->surfaces[TEX_HOOK], hookW, hookH, pivot);
+    buildRotatedSprite(&assets->hookSprites[HOOK_SPRITE_DYNAMITE], assets->surfaces[TEX_DYNAMITE], hookW, hookH, pivot);
+    if (assets->rasterImages) {
+        for (int i = 0; i < NUM_GAME_TEXTURES; i++)
+            initRasterImage(&assets->images[i], assets->surfaces[i], NULL);
+        for (int i = 0; i < NUM_HOOK_SPRITES; i++)
+            initRasterImage(&assets->hookImages[i], assets->hookSprites[i].sheet, NULL);
+    }
+    SDL_AtomicSet(&assets->decoded, 1);
+    return 0;
+}
+
+void startGameAssets(GameAssets* assets, int audioBuffer, const SdfFont* font, bool rasterImages) {
+    memset(assets, 0, sizeof(GameAssets));
+    assets->audioBuffer = audioBuffer;
+    assets->font = font;
+    assets->rasterImages = rasterImages;
+    assets->startTime = SDL_GetPerformanceCounter();
+    assets->thread = SDL_CreateThread(assetsWorker, "assets", assets);
+    if (!assets->thread) {
+        printf("Asset thread error: %s\n", SDL_GetError());
+        assetsWorker(assets);
+    }
+}
+
+bool pumpGameAssets(GameAssets* assets, SDL_Renderer* renderer) {
+    if (assets->ready)
+        return true;
+    if (!SDL_AtomicGet(&assets->decoded))
+        return false;
+    if (assets->thread) {
+        SDL_WaitThread(assets->thread, NULL);
+        assets->thread = NULL;
+    }
+    if (assets->uploaded < NUM_GAME_TEXTURES) {
+        int i = assets->uploaded++;
+        assets->textures[i] = trackedCreateTextureFromSurface(renderer, assets->surfaces[i]);
+        trackedFreeSurface(assets->surfaces[i]);
+        assets->surfaces[i] = NULL;
+        return false;
+    }
+    int sprite = assets->uploaded - NUM_GAME_TEXTURES;
+    if (sprite < NUM_HOOK_SPRITES) {
+        uploadRotatedSprite(&assets->hookSprites[sprite], renderer);
+        assets->uploaded++;
+        return false;
+    }
+    initTextAtlas(&assets->bigText, renderer, assets->font, 48);
+    assets->ready = true;
+    printf("Game assets ready %.0f ms after the menu started loading them\n",
+           (SDL_GetPerformanceCounter() - assets->startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+    return true;
+}
+
+void finishGameAssets(GameAssets* assets, SDL_Renderer* renderer) {
+    while (!pumpGameAssets(assets, renderer)) {
+        if (!SDL_AtomicGet(&assets->decoded))
+            SDL_Delay(1);
+    }
+}
+
+void freeGameAssets(GameAssets* assets) {
+    if (assets->thread) {
+        SDL_WaitThread(assets->thread, NULL);
+        assets->thread = NULL;
+    }
+    for (int i = 0; i < NUM_GAME_TEXTURES; i++) {
+        trackedFreeSurface(assets->surfaces[i]);
+        trackedDestroyTexture(assets->textures[i]);
+    }
+    for (int i = 0; i < NUM_HOOK_SPRITES; i++) {
+        freeRotatedSprite(&assets->hookSprites[i]);
+        freeRasterImage(&assets->hookImages[i]);
+    }
+    for (int i = 0; i < NUM_GAME_TEXTURES; i++)
+        freeRasterImage(&assets->images[i]);
+    freeTextAtlas(&assets->bigText);
+    if (assets->targetMusic)
+        Mix_FreeMusic(assets->targetMusic);
+    freeSfx();
+    Mix_CloseAudio();
+    memset(assets, 0, sizeof(GameAssets));
+}
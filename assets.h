@@ -0,0 +1,77 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <stdbool.h>
+#include "objects.h"
+#include "rotated_sprite.h"
+#include "soft_raster.h"
+#include "text_atlas.h"
+
+// Everything the rounds need that the menu does not. So that the menu can
+// open as soon as its own background and font are in, a worker thread
+// opens the audio device, decodes the sound effects, the target music and
+// the gameplay images while the menu is up. The main thread then turns the
+// images into textures one per menu frame, and lays out the 48pt text. The
+// worker also turns the hook and dynamite for every swing angle, and, for
+// --soft-raster, keeps premultiplied copies of the images for the CPU.
+
+typedef enum {
+    TEX_CHARACTER,
+    TEX_HOOK,
+    TEX_DYNAMITE,
+    TEX_EXPLOSION,
+    TEX_SUCCESS,
+    TEX_FAILURE,
+    TEX_TARGET,
+    TEX_OBJECTS,              // First object sprite, in ObjectSprite order.
+    NUM_GAME_TEXTURES = TEX_OBJECTS + NUM_OBJECT_SPRITES
+} GameTexture;
+
+typedef enum {
+    HOOK_SPRITE_HOOK,
+    HOOK_SPRITE_DYNAMITE,     // While it flies down the rope.
+    NUM_HOOK_SPRITES
+} HookSprite;
+
+typedef struct {
+    SDL_Thread* thread;
+    SDL_atomic_t decoded;     // The worker has finished.
+    int audioBuffer;
+    SDL_Surface* surfaces[NUM_GAME_TEXTURES];
+    SDL_Texture* textures[NUM_GAME_TEXTURES];
+    RotatedSprite hookSprites[NUM_HOOK_SPRITES];
+    bool rasterImages;
+    RasterImage images[NUM_GAME_TEXTURES];
+    RasterImage hookImages[NUM_HOOK_SPRITES];  // The sheets, laid out as in hookSprites.
+    int uploaded;             // Textures, then hook sprites, created so far.
+    const SdfFont* font;
+    TextAtlas bigText;        // 48pt, for the target screen.
+    Mix_Music* targetMusic;
+    bool ready;
+    Uint64 startTime;         // SDL_GetPerformanceCounter() at the start.
+} GameAssets;
+
+inline SDL_Texture* objectTexture(const GameAssets* assets, ObjectKind kind) {
+    return assets->textures[TEX_OBJECTS + (int)OBJECT_ARCHETYPES[kind].sprite];
+}
+
+inline const RasterImage* objectImage(const GameAssets* assets, ObjectKind kind) {
+    return &assets->images[TEX_OBJECTS + (int)OBJECT_ARCHETYPES[kind].sprite];
+}
+
+// Starts the worker. Call after IMG_Init. `font` must outlive the assets.
+void startGameAssets(GameAssets* assets, int audioBuffer, const SdfFont* font, bool rasterImages);
+
+// Does at most one main-thread step; call once per menu frame. Returns
+// true once everything is ready.
+bool pumpGameAssets(GameAssets* assets, SDL_Renderer* renderer);
+
+// Waits for the worker if it is still going and does every step left.
+void finishGameAssets(GameAssets* assets, SDL_Renderer* renderer);
+
+// Also closes the audio device.
+void freeGameAssets(GameAssets* assets);
+
+#endif // ASSETS_H
@@ -0,0 +1,361 @@
+#include "game.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "perf_counters.h"
+
+#define PI 3.14159265358979323846
+
+// Distance of each character from the level's anchor in a two-player round.
+#define VERSUS_SPACING 260
+
+// The hook catches things with a small box around its tip.
+#define HOOK_COLLISION_SIZE 20
+
+// Dynamite: the stick flies to the pulled object, then explodes and the
+// hook swings again.
+#define DYNAMITE_FLIGHT 0.05f
+#define DYNAMITE_BLAST 0.2f
+
+static_assert(std::is_trivially_copyable<Game>::value, "Game must stay copyable for snapshots");
+
+// xorshift32, so both machines roll the same mystery bags.
+static Uint32 nextRandom(Uint32* state) {
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+void initGame(Game* game, const LevelHeader* tuning, Mine* mine, int numPlayers, Uint32 seed) {
+    game->tuning = tuning;
+    game->mine = mine;
+    game->numPlayers = numPlayers;
+    game->tick = 0;
+    game->time = 0.0f;
+    game->timeLeft = tuning->timeLimit;
+    game->timeUp = false;
+    game->rng = seed ? seed : 0x9E3779B9u;
+    game->numTaken = 0;
+    game->numEvents = 0;
+    game->maxAngle = tuning->maxAngleDeg * (PI / 180.0f);
+    game->omega = 2 * PI / (tuning->periodMs / 1000.0f);
+    hookGeometry(&game->hookW, &game->hookH, &game->hookPivot);
+    int tops[MAX_PLAYERS];
+    for (int i = 0; i < numPlayers; i++) {
+        PlayerState* p = &game->players[i];
+        p->charRect = tuning->charRect;
+        if (numPlayers == 2)
+            p->charRect.x += i == 0 ? -VERSUS_SPACING : VERSUS_SPACING;
+        p->anchorX = p->charRect.x + p->charRect.w / 2.0f;
+        p->anchorY = p->charRect.y + p->charRect.h / 2.0f;
+        p->hookState = OSCILLATING;
+        p->currentAngle = 0.0f;
+        p->storedAngle = 0.0f;
+        p->currentR = tuning->baseR;
+        p->phaseOffset = 0.0f;
+        p->refTime = 0.0f;
+        p->hookX = p->anchorX;
+        p->hookY = p->anchorY + tuning->baseR;
+        p->carrying = false;
+        p->carriedRect = (SDL_Rect){0, 0, 0, 0};
+        p->carriedKind = GOLD_SMALL;
+        p->explosionX = 0.0f;
+        p->explosionY = 0.0f;
+        p->score = 0;
+        p->dynamites = 0;
+        p->effectTime = 0.0f;
+        tops[i] = hookViewTop(game, i);
+    }
+    streamMine(mine, tops, numPlayers, game->taken, 0);
+}
+
+void restoreGame(Game* game, const Game* snapshot) {
+    memcpy(game, snapshot, sizeof(Game));
+    int tops[MAX_PLAYERS];
+    for (int i = 0; i < game->numPlayers; i++)
+        tops[i] = hookViewTop(game, i);
+    refreshMine(game->mine, game->taken, game->numTaken);
+    streamMine(game->mine, tops, game->numPlayers, game->taken, game->numTaken);
+}
+
+InputAction stampInput(Uint32 timestamp, Uint32 startTicks, InputKind kind, int player) {
+    Uint32 ms = (Sint32)(timestamp - startTicks) > 0 ? timestamp - startTicks : 0;
+    Uint64 subTicks = (Uint64)ms * SIM_RATE * 256 / 1000;
+    InputAction input;
+    input.tick = (Uint32)(subTicks >> 8);
+    input.offset = (Uint8)(subTicks & 255);
+    input.kind = (Uint8)kind;
+    input.player = (Uint8)player;
+    return input;
+}
+
+int hookViewTop(const Game* game, int player) {
+    // Keep the hook in the upper part of the view so the player sees what
+    // lies below it.
+    int top = (int)game->players[player].hookY - VIEW_HEIGHT * 2 / 5;
+    if (top > game->mine->depth - VIEW_HEIGHT) top = game->mine->depth - VIEW_HEIGHT;
+    if (top < 0) top = 0;
+    return top;
+}
+
+SDL_Rect hookRect(const Game* game, const PlayerState* p) {
+    SDL_Rect rect = {(int)p->hookX - game->hookW / 2, (int)p->hookY - game->hookH / 2, game->hookW, game->hookH};
+    return rect;
+}
+
+void hookGeometry(int* w, int* h, SDL_Point* pivot) {
+    // hook.png is 928x665, tied at (465, 77).
+    float scaleFactor = 0.05f;
+    *w = (int)(928 * scaleFactor);
+    *h = (int)(665 * scaleFactor);
+    *pivot = (SDL_Point){(int)(465 * scaleFactor + 0.5f), (int)(77 * scaleFactor + 0.5f)};
+}
+
+static void addEvent(Game* game, int player, GameEventKind kind, int detail, int a, int b) {
+    if (game->numEvents == MAX_TICK_EVENTS)
+        return;
+    GameEvent* e = &game->events[game->numEvents++];
+    e->kind = (Uint8)kind;
+    e->player = (Uint8)player;
+    e->detail = (Uint16)detail;
+    e->a = a;
+    e->b = b;
+}
+
+static int millidegrees(float radians) {
+    return (int)(radians * (180000.0f / PI));
+}
+
+static void scoreCatch(Game* game, PlayerState* p) {
+    if (!p->carrying)
+        return;
+    const ObjectArchetype* a = &OBJECT_ARCHETYPES[p->carriedKind];
+    // Only kinds with a choice of outcomes draw from the shared random
+    // stream, so plain catches leave the sequence alone.
+    const ObjectOutcome* o = &a->outcomes[0];
+    int player = (int)(p - game->players);
+    if (a->numOutcomes > 1) {
+        int r = nextRandom(&game->rng) % 100;
+        while (r >= o->below)
+            o++;
+        addEvent(game, player, GAME_EVENT_MYSTERY, (int)(o - a->outcomes), r, 0);
+    }
+    p->score += o->points;
+    p->dynamites += o->dynamites;
+    addEvent(game, player, GAME_EVENT_CATCH, p->carriedKind, o->points, o->dynamites);
+    p->carrying = false;
+}
+
+// Moves one hook on by dt; game->time is already the end of the step.
+static void advancePlayer(Game* game, PlayerState* p, float dt) {
+    const LevelHeader* tuning = game->tuning;
+    float baseR = tuning->baseR;
+    switch (p->hookState) {
+        case OSCILLATING: {
+            float t = game->time - p->refTime;
+            p->currentAngle = game->maxAngle * sin(game->omega * t + p->phaseOffset);
+            p->currentR = baseR;
+            p->hookX = p->anchorX + p->currentR * sin(p->currentAngle);
+            p->hookY = p->anchorY + p->currentR * cos(p->currentAngle);
+            break;
+        }
+        case PULLING_DOWN: {
+            p->currentR += tuning->droppingSpeed * dt;
+            p->hookX = p->anchorX + p->currentR * sin(p->storedAngle);
+            p->hookY = p->anchorY + p->currentR * cos(p->storedAngle);
+            bool bottom = p->hookY + game->hookH/2 >= game->mine->depth;
+            if (bottom || p->hookX - game->hookW/2 <= 0 || p->hookX + game->hookW/2 >= VIEW_WIDTH) {
+                p->hookState = ROLLING_BACK;
+                addEvent(game, (int)(p - game->players), GAME_EVENT_WALL_HIT, bottom, (int)p->hookX, (int)p->hookY);
+            }
+            break;
+        }
+        case ROLLING_BACK: {
+            p->currentR -= tuning->droppingSpeed * dt;
+            p->hookX = p->anchorX + p->currentR * sin(p->storedAngle);
+            p->hookY = p->anchorY + p->currentR * cos(p->storedAngle);
+            if (p->currentR <= baseR + 1.0f) {
+                p->currentR = baseR;
+                p->phaseOffset = asin(p->storedAngle / game->maxAngle);
+                p->refTime = game->time;
+                p->hookState = OSCILLATING;
+                addEvent(game, (int)(p - game->players), GAME_EVENT_MISS, 0, millidegrees(p->storedAngle), 0);
+            }
+            break;
+        }
+        case PULLING_GOLD: {
+            float retractSpeed = tuning->pullSpeed * OBJECT_ARCHETYPES[p->carriedKind].retractScale;
+            p->currentR -= retractSpeed * dt;
+            p->hookX = p->anchorX + p->currentR * sin(p->storedAngle);
+            p->hookY = p->anchorY + p->currentR * cos(p->storedAngle);
+            SDL_Rect rect = hookRect(game, p);
+            p->carriedRect.x = rect.x + game->hookPivot.x - p->carriedRect.w/2;
+            p->carriedRect.y = rect.y + game->hookPivot.y - p->carriedRect.h/2;
+            if (p->currentR <= baseR + 1.0f) {
+                p->currentR = baseR;
+                p->hookState = OSCILLATING;
+                p->phaseOffset = asin(p->storedAngle / game->maxAngle);
+                p->refTime = game->time;
+                scoreCatch(game, p);
+            }
+            break;
+        }
+        case dynamite_MOVING: {
+            p->effectTime -= dt;
+            if (p->effectTime <= 0.0f) {
+                p->effectTime += DYNAMITE_BLAST;
+                p->hookState = dynamite_EXPLOSION;
+            }
+            break;
+        }
+        case dynamite_EXPLOSION: {
+            p->effectTime -= dt;
+            if (p->effectTime <= 0.0f) {
+                p->currentR = baseR;
+                p->phaseOffset = asin(p->storedAngle / game->maxAngle);
+                p->refTime = game->time;
+                p->hookState = OSCILLATING;
+            }
+            break;
+        }
+    }
+}
+
+static void advanceGame(Game* game, float dt) {
+    game->time += dt;
+    for (int i = 0; i < game->numPlayers; i++)
+        advancePlayer(game, &game->players[i], dt);
+}
+
+static void applyInput(Game* game, const InputAction* input) {
+    if (input->player >= game->numPlayers)
+        return;
+    PlayerState* p = &game->players[input->player];
+    if (input->kind == INPUT_RELEASE && p->hookState == OSCILLATING) {
+        p->hookState = PULLING_DOWN;
+        p->storedAngle = p->currentAngle;
+    } else if (input->kind == INPUT_DYNAMITE && p->hookState == PULLING_GOLD && p->dynamites > 0 && p->carrying) {
+        p->hookState = dynamite_MOVING;
+        p->effectTime = DYNAMITE_FLIGHT;
+        p->explosionX = p->hookX;
+        p->explosionY = p->hookY;
+        p->carrying = false;
+        p->dynamites--;
+        addEvent(game, input->player, GAME_EVENT_DYNAMITE, p->carriedKind, p->dynamites, 0);
+    }
+}
+
+// Grabs the object nearest the hook tip, if the tip touches any.
+static void collideHook(Game* game, PlayerState* p) {
+    SDL_Rect rect = hookRect(game, p);
+    int hookCenterX = rect.x + game->hookPivot.x;
+    int hookCenterY = rect.y + game->hookPivot.y;
+    SDL_Rect hookCollision = {(int)p->hookX - HOOK_COLLISION_SIZE/2, (int)p->hookY - HOOK_COLLISION_SIZE/2,
+                              HOOK_COLLISION_SIZE, HOOK_COLLISION_SIZE};
+    MineChunk* nearChunks[MINE_RESIDENT_CHUNKS];
+    int numNear = findMineChunks(game->mine, hookCollision.y, hookCollision.y + hookCollision.h, nearChunks);
+    float bestDist = 1e9f;
+    MineChunk* bestChunk = NULL;
+    int bestIndex = -1;
+    bool bestIsRock = false;
+    for (int c = 0; c < numNear; c++) {
+        MineChunk* chunk = nearChunks[c];
+        for (int i = 0; i < chunk->numGolds; i++) {
+            const GoldObject* gold = &chunk->golds[i];
+            if (gold->active && SDL_HasIntersection(&hookCollision, &gold->rect)) {
+                float dx = (float)(gold->rect.x + gold->rect.w/2 - hookCenterX);
+                float dy = (float)(gold->rect.y + gold->rect.h/2 - hookCenterY);
+                float dist = dx * dx + dy * dy;
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    bestChunk = chunk;
+                    bestIndex = i;
+                    bestIsRock = false;
+                }
+            }
+        }
+        for (int i = 0; i < chunk->numRocks; i++) {
+            const RockObject* rock = &chunk->rocks[i];
+            if (rock->active && SDL_HasIntersection(&hookCollision, &rock->rect)) {
+                float dx = (float)(rock->rect.x + rock->rect.w/2 - hookCenterX);
+                float dy = (float)(rock->rect.y + rock->rect.h/2 - hookCenterY);
+                float dist = dx * dx + dy * dy;
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    bestChunk = chunk;
+                    bestIndex = i;
+                    bestIsRock = true;
+                }
+            }
+        }
+    }
+    if (bestChunk == NULL)
+        return;
+    p->hookState = PULLING_GOLD;
+    p->carrying = true;
+    if (bestIsRock) {
+        p->carriedRect = bestChunk->rocks[bestIndex].rect;
+        p->carriedKind = bestChunk->rocks[bestIndex].type;
+    } else {
+        p->carriedRect = bestChunk->golds[bestIndex].rect;
+        p->carriedKind = bestChunk->golds[bestIndex].type;
+    }
+    if (!takeMineObject(bestChunk, bestIsRock, bestIndex, game->taken, &game->numTaken))
+        addEvent(game, (int)(p - game->players), GAME_EVENT_MINE_FULL, 0, bestChunk->index, 0);
+    addEvent(game, (int)(p - game->players), GAME_EVENT_GRAB, p->carriedKind, (int)p->hookY, millidegrees(p->storedAngle));
+}
+
+void stepGame(Game* game, const InputAction* inputs, int numInputs) {
+    game->numEvents = 0;
+    if (game->timeUp) {
+        game->tick++;
+        return;
+    }
+    // Apply the commands in the order they happened, each at its own point
+    // inside the tick; simultaneous ones go to the lower player first.
+    InputAction sorted[MAX_TICK_INPUTS];
+    int n = 0;
+    for (int i = 0; i < numInputs && n < MAX_TICK_INPUTS; i++) {
+        int j = n++;
+        while (j > 0 && (sorted[j - 1].offset > inputs[i].offset ||
+                         (sorted[j - 1].offset == inputs[i].offset && sorted[j - 1].player > inputs[i].player))) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = inputs[i];
+    }
+    int done = 0; // Sub-ticks simulated so far
+    for (int i = 0; i < n; i++) {
+        advanceGame(game, (sorted[i].offset - done) * (SIM_DT / 256.0f));
+        done = sorted[i].offset;
+        applyInput(game, &sorted[i]);
+    }
+    advanceGame(game, (256 - done) * (SIM_DT / 256.0f));
+    game->time = (game->tick + 1) * SIM_DT;
+
+    // Bring in the mine around every hook, then let the hooks grab.
+    int tops[MAX_PLAYERS];
+    for (int i = 0; i < game->numPlayers; i++)
+        tops[i] = hookViewTop(game, i);
+    streamMine(game->mine, tops, game->numPlayers, game->taken, game->numTaken);
+    PerfPhase outer = beginPerfPhase(PERF_COLLISION);
+    for (int i = 0; i < game->numPlayers; i++) {
+        if (game->players[i].hookState == PULLING_DOWN)
+            collideHook(game, &game->players[i]);
+    }
+    beginPerfPhase(outer);
+
+    // Counted in whole ticks so the round ends on the same tick everywhere.
+    game->tick++;
+    game->timeLeft = game->tuning->timeLimit - game->tick * SIM_DT;
+    if (game->tick >= (Uint32)(game->tuning->timeLimit * SIM_RATE + 0.5f)) {
+        game->timeLeft = 0;
+        game->timeUp = true;
+        for (int i = 0; i < game->numPlayers; i++)
+            addEvent(game, i, GAME_EVENT_ROUND_END, 0, game->players[i].score, game->tuning->target);
+    }
+}
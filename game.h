@@ -0,0 +1,115 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "input.h"
+#include "level.h"
+#include "mine.h"
+
+#define MAX_PLAYERS 2
+
+// The round is simulated in fixed ticks so that two machines fed the same
+// inputs reach the same state. Game holds no pointers into itself and owns
+// no memory, so a plain copy is a snapshot of the round.
+#define SIM_RATE 60
+#define SIM_DT (1.0f / SIM_RATE)
+
+typedef enum { OSCILLATING, PULLING_DOWN, ROLLING_BACK, PULLING_GOLD, dynamite_MOVING, dynamite_EXPLOSION } HookState;
+
+// Things that happen to a hook, reported tick by tick for the telemetry
+// log. `detail`, `a` and `b` depend on the kind:
+//   GRAB       object kind, hook depth, angle in millidegrees
+//   MISS       -, angle in millidegrees, -      (empty hook is back up)
+//   WALL_HIT   0 side or 1 bottom, hook x, hook y
+//   DYNAMITE   object kind blown up, dynamites left, -
+//   CATCH      object kind, points, dynamites gained
+//   MYSTERY    outcome index, roll (0-99), -
+//   ROUND_END  -, score, target
+//   MINE_FULL  -, chunk that may refill, -   (the taken list is full)
+typedef enum {
+    GAME_EVENT_GRAB,
+    GAME_EVENT_MISS,
+    GAME_EVENT_WALL_HIT,
+    GAME_EVENT_DYNAMITE,
+    GAME_EVENT_CATCH,
+    GAME_EVENT_MYSTERY,
+    GAME_EVENT_ROUND_END,
+    GAME_EVENT_MINE_FULL,
+    NUM_GAME_EVENTS
+} GameEventKind;
+
+typedef struct {
+    Uint8 kind;
+    Uint8 player;
+    Uint16 detail;
+    Sint32 a, b;
+} GameEvent;
+
+#define MAX_TICK_EVENTS (4 * MAX_PLAYERS)
+
+// One player's hook and haul.
+typedef struct {
+    SDL_Rect charRect;        // Character sprite; the rope hangs from its centre.
+    float anchorX, anchorY;
+    HookState hookState;
+    float currentAngle, storedAngle, currentR;
+    float phaseOffset;
+    float refTime;            // Game time the current swing started at.
+    float hookX, hookY;
+    bool carrying;            // The pulled object leaves the mine and hangs from the hook.
+    SDL_Rect carriedRect;
+    ObjectKind carriedKind;
+    float explosionX, explosionY;
+    int score;
+    int dynamites;
+    float effectTime;         // Seconds left in the current dynamite phase.
+} PlayerState;
+
+typedef struct {
+    const LevelHeader* tuning;
+    Mine* mine;
+    int numPlayers;
+    PlayerState players[MAX_PLAYERS];
+    Uint32 tick;              // Next tick to simulate.
+    float time;               // Game time in seconds.
+    float timeLeft;
+    bool timeUp;
+    Uint32 rng;               // Mystery bag rolls; seeded the same on every machine.
+    MineTaken taken[MINE_MAX_TAKEN];  // The mine itself is only a cache of these.
+    int numTaken;
+    float maxAngle, omega;
+    int hookW, hookH;
+    SDL_Point hookPivot;
+    GameEvent events[MAX_TICK_EVENTS];  // What happened in the last tick.
+    int numEvents;
+} Game;
+
+// Sets up a round for one or two players. With two, the characters stand
+// either side of the level's anchor.
+void initGame(Game* game, const LevelHeader* tuning, Mine* mine, int numPlayers, Uint32 seed);
+
+// Turns an SDL timestamp into the tick and sub-tick position it falls in.
+// `startTicks` is the SDL_GetTicks() time of tick 0.
+InputAction stampInput(Uint32 timestamp, Uint32 startTicks, InputKind kind, int player);
+
+// Simulates one tick. `inputs` are the commands for game->tick, from every
+// player, in any order. Replaces game->events with that tick's events.
+void stepGame(Game* game, const InputAction* inputs, int numInputs);
+
+// Puts the round back to a copy taken earlier in the same round, and brings
+// the shared mine in line with it.
+void restoreGame(Game* game, const Game* snapshot);
+
+// Top of the view that follows a player's hook. The game streams the mine
+// around these views, so a camera using them never waits on a chunk.
+int hookViewTop(const Game* game, int player);
+
+// The hook sprite's rect, in mine coordinates.
+SDL_Rect hookRect(const Game* game, const PlayerState* player);
+
+// Size of the hook sprite on screen and where on it the rope is tied, the
+// same for every level. The dynamite is drawn over the same rect.
+void hookGeometry(int* w, int* h, SDL_Point* pivot);
+
+#endif // GAME_H
@@ -1,6 +1,7 @@
 #include "high_scores.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include "metrics.h"
 
 void updateHighScores(int newScore) {
     int scores[5];
@@ -60,7 +61,7 @@ void updateHighScores(int newScore) {
     }
 }
 
-void showHighScores(SDL_Renderer* renderer, TTF_Font* font) {
+void showHighScores(SDL_Renderer* renderer, const TextAtlas* text) {
     // First, updateHighScores with a dummy score (0) so that the file exists
     updateHighScores(0);
     char lines[5][128] = { {0} };
@@ -83,22 +84,11 @@ void showHighScores(SDL_Renderer* renderer, TTF_Font* font) {
         }
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 200); // Semi-transparent black background
         SDL_RenderClear(renderer);
-        SDL_Color white = {255, 255, 255, 255};
         // Render each high score line (placed with some left margin and vertical spacing)
-        for (int i = 0; i < 5; i++) {
-            SDL_Surface* surf = TTF_RenderText_Blended(font, lines[i], white);
-            if (surf) {
-                SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surf);
-                SDL_FreeSurface(surf);
-                SDL_Rect rect;
-                rect.x = 100;
-                rect.y = 150 + i * 50;
-                SDL_QueryTexture(tex, NULL, NULL, &rect.w, &rect.h);
-                SDL_RenderCopy(renderer, tex, NULL, &rect);
-                SDL_DestroyTexture(tex);
-            }
-        }
+        for (int i = 0; i < 5; i++)
+            drawText(text, renderer, lines[i], 100, 150 + i * 50);
         SDL_RenderPresent(renderer);
+        endMetricsFrame();
         SDL_Delay(16);
     }
 }
@@ -2,7 +2,7 @@
 #define HIGH_SCORES_H
 
 #include <SDL.h>
-#include <SDL_ttf.h>
+#include "text_atlas.h"
 
 // Updates the high-scores file with the new score.
 // The file "highscores.txt" stores up to 5 scores (sorted descending).
@@ -10,6 +10,6 @@
 void updateHighScores(int newScore);
 
 // Reads from the high-scores file and renders the 5 high-score lines.
-void showHighScores(SDL_Renderer* renderer, TTF_Font* font);
+void showHighScores(SDL_Renderer* renderer, const TextAtlas* text);
 
 #endif // HIGH_SCORES_H
@@ -0,0 +1,25 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL.h>
+
+// Player commands.
+typedef enum {
+    INPUT_RELEASE,            // Drop the hook.
+    INPUT_DYNAMITE            // Blow up whatever the hook is pulling.
+} InputKind;
+
+// A command placed at the exact point in the simulation it was given: key
+// presses carry their SDL event timestamp, which stampInput (game.h) turns
+// into a tick and a position inside it.
+typedef struct {
+    Uint32 tick;
+    Uint8 offset;             // Position inside the tick, in 1/256ths.
+    Uint8 kind;
+    Uint8 player;
+} InputAction;
+
+// Commands applied per tick; more than this in one tick are dropped.
+#define MAX_TICK_INPUTS 16
+
+#endif // INPUT_H
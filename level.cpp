@@ -0,0 +1,383 @@
+#include "level.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "mine.h"
+
+// Size of the block holding the header and both object arrays. This is also
+// the exact size of a compiled level file.
+static size_t levelBlockSize(int numGolds, int numRocks) {
+    return sizeof(LevelHeader) + (size_t)numGolds * sizeof(GoldObject) + (size_t)numRocks * sizeof(RockObject);
+}
+
+// Points header/golds/rocks into an already filled block.
+static void bindLevel(Level* level, void* block, size_t blockSize, Arena* arena) {
+    level->arena = arena;
+    level->block = block;
+    level->blockSize = blockSize;
+    level->header = (LevelHeader*)block;
+    level->golds = (GoldObject*)((char*)block + sizeof(LevelHeader));
+    level->rocks = (RockObject*)(level->golds + level->header->numGolds);
+}
+
+// Fills in the values the game used before levels were data-driven, so a
+// text level only has to list what it changes.
+static void setDefaultHeader(LevelHeader* header) {
+    memset(header, 0, sizeof(LevelHeader));
+    header->magic = LEVEL_MAGIC;
+    header->version = LEVEL_VERSION;
+    header->charRect = (SDL_Rect){583, 90, 200, 100};
+    header->baseR = 70.0f;
+    header->maxAngleDeg = 75.0f;
+    header->periodMs = 2000.0f;
+    header->droppingSpeed = 1000.0f;
+    header->pullSpeed = 200.0f;
+    header->timeLimit = 60.0f;
+    header->target = 400;
+    strcpy(header->background, "background.png");
+    header->depth = 768;
+}
+
+static bool parseObjectKind(const char* name, bool isRock, ObjectKind* kind) {
+    for (int k = 0; k < NUM_OBJECT_KINDS; k++) {
+        if (OBJECT_ARCHETYPES[k].isRock == isRock && strcmp(name, OBJECT_ARCHETYPES[k].name) == 0) {
+            *kind = (ObjectKind)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Object kinds index the archetype table, so a compiled level must not
+// carry one that is out of range or stored in the wrong array.
+static bool kindsValid(const Level* level) {
+    for (int i = 0; i < level->header->numGolds; i++) {
+        ObjectKind k = level->golds[i].type;
+        if (k < 0 || k >= NUM_OBJECT_KINDS || OBJECT_ARCHETYPES[k].isRock)
+            return false;
+    }
+    for (int i = 0; i < level->header->numRocks; i++) {
+        ObjectKind k = level->rocks[i].type;
+        if (k < 0 || k >= NUM_OBJECT_KINDS || !OBJECT_ARCHETYPES[k].isRock)
+            return false;
+    }
+    return true;
+}
+
+// The tuning both loaders must agree on before the game divides by it.
+// Returns what is wrong, or NULL if nothing is.
+static const char* checkHeader(const LevelHeader* h) {
+    if (memchr(h->background, '\0', sizeof(h->background)) == NULL)
+        return "background name is not terminated";
+    if (h->numGolds < 0 || h->numRocks < 0)
+        return "negative object count";
+    if (h->depth < 768)
+        return "depth below one screen";
+    if (!(h->maxAngleDeg > 0.0f && h->maxAngleDeg < 90.0f))
+        return "swing angle must be between 0 and 90 degrees";
+    if (!(h->periodMs > 0.0f) || !isfinite(h->periodMs))
+        return "swing period must be positive";
+    if (!(h->baseR > 0.0f) || !isfinite(h->baseR))
+        return "rope length must be positive";
+    if (!(h->droppingSpeed > 0.0f && h->pullSpeed > 0.0f) || !isfinite(h->droppingSpeed) || !isfinite(h->pullSpeed))
+        return "speeds must be positive";
+    if (!(h->timeLimit > 0.0f) || !isfinite(h->timeLimit))
+        return "time limit must be positive";
+    return NULL;
+}
+
+// What the mine needs of an object: it must fit within the reach it is
+// allowed into the next chunk, and a seeded mine generates everything
+// below the first screen, so authored objects there would never show up.
+static const char* checkObject(const LevelHeader* h, const SDL_Rect* rect) {
+    if (rect->w <= 0 || rect->h <= 0)
+        return "object with no size";
+    if (rect->h > MINE_OBJECT_REACH)
+        return "object taller than MINE_OBJECT_REACH";
+    if (h->mineSeed != 0 && rect->y >= VIEW_HEIGHT)
+        return "object below the first screen of a generated mine";
+    return NULL;
+}
+
+// The chunk the mine files an object under.
+static int objectChunk(const SDL_Rect* rect, int numChunks) {
+    int c = rect->y > 0 ? rect->y / CHUNK_HEIGHT : 0;
+    return c < numChunks ? c : numChunks - 1;
+}
+
+// Most objects chunk c can hold once the mine has it: the level's own, or
+// a full generated chunk's below the first screen of a seeded mine.
+static int chunkObjects(const Level* level, int c, int numChunks) {
+    if (level->header->mineSeed != 0 && c * CHUNK_HEIGHT >= VIEW_HEIGHT)
+        return CHUNK_MAX_GOLDS + CHUNK_MAX_ROCKS;
+    int n = 0;
+    for (int i = 0; i < level->header->numGolds; i++)
+        n += objectChunk(&level->golds[i].rect, numChunks) == c;
+    for (int i = 0; i < level->header->numRocks; i++)
+        n += objectChunk(&level->rocks[i].rect, numChunks) == c;
+    return n;
+}
+
+static const char* checkObjects(const Level* level) {
+    const char* problem = NULL;
+    for (int i = 0; i < level->header->numGolds && problem == NULL; i++)
+        problem = checkObject(level->header, &level->golds[i].rect);
+    for (int i = 0; i < level->header->numRocks && problem == NULL; i++)
+        problem = checkObject(level->header, &level->rocks[i].rect);
+    if (problem != NULL)
+        return problem;
+    // Every view must be able to show all it reaches.
+    int numChunks = (level->header->depth + CHUNK_HEIGHT - 1) / CHUNK_HEIGHT;
+    int window = 0;
+    for (int c = 0; c < numChunks; c++) {
+        window += chunkObjects(level, c, numChunks);
+        if (c >= MINE_VIEW_CHUNKS)
+            window -= chunkObjects(level, c - MINE_VIEW_CHUNKS, numChunks);
+        if (window > MINE_VIEW_MAX_OBJECTS)
+            return "more than MINE_VIEW_MAX_OBJECTS objects within reach of one view";
+    }
+    return NULL;
+}
+
+bool allocLevel(Level* level, int numGolds, int numRocks, Arena* arena) {
+    size_t blockSize = levelBlockSize(numGolds, numRocks);
+    void* block = arenaCalloc(arena, blockSize);
+    if (block == NULL)
+        return false;
+    LevelHeader* header = (LevelHeader*)block;
+    setDefaultHeader(header);
+    header->fileSize = (Uint32)blockSize;
+    header->numGolds = numGolds;
+    header->numRocks = numRocks;
+    bindLevel(level, block, blockSize, arena);
+    return true;
+}
+
+bool copyLevel(const Level* level, Level* copy, Arena* arena) {
+    void* block = arenaAlloc(arena, level->blockSize);
+    if (block == NULL)
+        return false;
+    memcpy(block, level->block, level->blockSize);
+    bindLevel(copy, block, level->blockSize, arena);
+    return true;
+}
+
+bool loadLevelText(const char* path, Level* level, Arena* arena) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Error opening level %s\n", path);
+        return false;
+    }
+    // First pass: count objects so the whole level fits in one allocation.
+    char line[256];
+    char word[32];
+    int numGolds = 0, numRocks = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "%31s", word) != 1)
+            continue;
+        if (strcmp(word, "gold") == 0)
+            numGolds++;
+        else if (strcmp(word, "rock") == 0)
+            numRocks++;
+    }
+    if (!allocLevel(level, numGolds, numRocks, arena)) {
+        fclose(file);
+        return false;
+    }
+    LevelHeader* header = level->header;
+
+    // Second pass: fill in tuning and objects.
+    rewind(file);
+    int lineNo = 0, g = 0, r = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        lineNo++;
+        char* comment = strchr(line, '#');
+        if (comment != NULL)
+            *comment = '\0';
+        if (sscanf(line, "%31s", word) != 1)
+            continue;
+        char name[32];
+        SDL_Rect rect;
+        if (strcmp(word, "gold") == 0) {
+            ObjectKind type;
+            ok = sscanf(line, "%*s %31s %d %d %d %d", name, &rect.x, &rect.y, &rect.w, &rect.h) == 5 && parseObjectKind(name, false, &type);
+            if (ok) {
+                level->golds[g].rect = rect;
+                level->golds[g].type = type;
+                level->golds[g].active = true;
+                g++;
+            }
+        } else if (strcmp(word, "rock") == 0) {
+            ObjectKind type;
+            ok = sscanf(line, "%*s %31s %d %d %d %d", name, &rect.x, &rect.y, &rect.w, &rect.h) == 5 && parseObjectKind(name, true, &type);
+            if (ok) {
+                level->rocks[r].rect = rect;
+                level->rocks[r].type = type;
+                level->rocks[r].active = true;
+                r++;
+            }
+        } else if (strcmp(word, "target") == 0) {
+            ok = sscanf(line, "%*s %d", &header->target) == 1;
+        } else if (strcmp(word, "time") == 0) {
+            ok = sscanf(line, "%*s %f", &header->timeLimit) == 1;
+        } else if (strcmp(word, "anchor") == 0) {
+            SDL_Rect* c = &header->charRect;
+            ok = sscanf(line, "%*s %d %d %d %d", &c->x, &c->y, &c->w, &c->h) == 4;
+        } else if (strcmp(word, "swing") == 0) {
+            ok = sscanf(line, "%*s %f %f %f", &header->baseR, &header->maxAngleDeg, &header->periodMs) == 3;
+        } else if (strcmp(word, "speed") == 0) {
+            ok = sscanf(line, "%*s %f %f", &header->droppingSpeed, &header->pullSpeed) == 2;
+        } else if (strcmp(word, "background") == 0) {
+            ok = sscanf(line, "%*s %63s", header->background) == 1;
+        } else if (strcmp(word, "depth") == 0) {
+            ok = sscanf(line, "%*s %d", &header->depth) == 1;
+        } else if (strcmp(word, "mine") == 0) {
+            ok = sscanf(line, "%*s %u", &header->mineSeed) == 1;
+        } else {
+            ok = false;
+        }
+    }
+    fclose(file);
+    if (!ok) {
+        printf("Error in level %s, line %d: %s", path, lineNo, line);
+        freeLevel(level);
+        return false;
+    }
+    const char* problem = checkHeader(header);
+    if (problem == NULL)
+        problem = checkObjects(level);
+    if (problem != NULL) {
+        printf("Error in level %s: %s\n", path, problem);
+        freeLevel(level);
+        return false;
+    }
+    return true;
+}
+
+bool saveLevelText(const char* path, const Level* level) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error writing level %s\n", path);
+        return false;
+    }
+    const LevelHeader* h = level->header;
+    fprintf(file, "target %d\n", h->target);
+    fprintf(file, "time %g\n", h->timeLimit);
+    fprintf(file, "anchor %d %d %d %d\n", h->charRect.x, h->charRect.y, h->charRect.w, h->charRect.h);
+    fprintf(file, "swing %g %g %g\n", h->baseR, h->maxAngleDeg, h->periodMs);
+    fprintf(file, "speed %g %g\n", h->droppingSpeed, h->pullSpeed);
+    fprintf(file, "background %s\n", h->background);
+    fprintf(file, "depth %d\n", h->depth);
+    if (h->mineSeed != 0)
+        fprintf(file, "mine %u\n", h->mineSeed);
+    fprintf(file, "\n");
+    for (int i = 0; i < h->numGolds; i++) {
+        const SDL_Rect* r = &level->golds[i].rect;
+        fprintf(file, "gold %s %d %d %d %d\n", OBJECT_ARCHETYPES[level->golds[i].type].name, r->x, r->y, r->w, r->h);
+    }
+    for (int i = 0; i < h->numRocks; i++) {
+        const SDL_Rect* r = &level->rocks[i].rect;
+        fprintf(file, "rock %s %d %d %d %d\n", OBJECT_ARCHETYPES[level->rocks[i].type].name, r->x, r->y, r->w, r->h);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+bool loadLevelBinary(const char* path, Level* level, Arena* arena) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error opening level %s\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < (long)sizeof(LevelHeader)) {
+        printf("Level %s is truncated\n", path);
+        fclose(file);
+        return false;
+    }
+    void* block = arenaAlloc(arena, (size_t)size);
+    if (block == NULL) {
+        fclose(file);
+        return false;
+    }
+    size_t got = fread(block, 1, (size_t)size, file);
+    fclose(file);
+    const LevelHeader* header = (const LevelHeader*)block;
+    if (got != (size_t)size || header->magic != LEVEL_MAGIC || header->version != LEVEL_VERSION ||
+        header->numGolds < 0 || header->numRocks < 0 || header->fileSize != (Uint32)size ||
+        levelBlockSize(header->numGolds, header->numRocks) != (size_t)size) {
+        printf("Level %s is not a valid compiled level (rebuild it with levelc)\n", path);
+        arenaFree(arena, block);
+        return false;
+    }
+    const char* problem = checkHeader(header);
+    if (problem != NULL) {
+        printf("Error in level %s: %s\n", path, problem);
+        arenaFree(arena, block);
+        return false;
+    }
+    bindLevel(level, block, (size_t)size, arena);
+    if (!kindsValid(level)) {
+        printf("Level %s has unknown object kinds (rebuild it with levelc)\n", path);
+        freeLevel(level);
+        return false;
+    }
+    problem = checkObjects(level);
+    if (problem != NULL) {
+        printf("Error in level %s: %s\n", path, problem);
+        freeLevel(level);
+        return false;
+    }
+    return true;
+}
+
+bool saveLevelBinary(const char* path, const Level* level) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error writing level %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(level->block, 1, level->blockSize, file) == level->blockSize;
+    fclose(file);
+    return ok;
+}
+
+bool loadLevel(const char* path, Level* level, Arena* arena) {
+    size_t len = strlen(path);
+    if (len > 4 && strcmp(path + len - 4, ".lvl") == 0)
+        return loadLevelBinary(path, level, arena);
+    return loadLevelText(path, level, arena);
+}
+
+bool findLevelFile(int index, char* out, size_t outSize) {
+    char textPath[LEVEL_PATH_LEN];
+    char binPath[LEVEL_PATH_LEN];
+    snprintf(textPath, sizeof(textPath), "levels/level%d.txt", index);
+    snprintf(binPath, sizeof(binPath), "levels/level%d.lvl", index);
+    struct stat textStat, binStat;
+    bool hasText = stat(textPath, &textStat) == 0;
+    bool hasBin = stat(binPath, &binStat) == 0;
+    // A compiled level older than its source is stale; use the text instead.
+    if (hasBin && (!hasText || binStat.st_mtime >= textStat.st_mtime))
+        snprintf(out, outSize, "%s", binPath);
+    else if (hasText)
+        snprintf(out, outSize, "%s", textPath);
+    else
+        return false;
+    return true;
+}
+
+void freeLevel(Level* level) {
+    arenaFree(level->arena, level->block);
+    level->block = NULL;
+    level->blockSize = 0;
+    level->header = NULL;
+    level->golds = NULL;
+    level->rocks = NULL;
+}
@@ -0,0 +1,78 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "objects.h"
+
+// Compiled level files start with this magic ("DGVL") and version.
+#define LEVEL_MAGIC 0x4C564744u
+#define LEVEL_VERSION 3
+#define LEVEL_PATH_LEN 64
+
+// Per-level tuning. This struct is also the header of the compiled (.lvl)
+// form, which is followed directly by numGolds GoldObjects and numRocks
+// RockObjects, so it must stay a plain fixed-size struct.
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 fileSize;
+    SDL_Rect charRect;        // Character sprite; the rope hangs from its centre.
+    float baseR;              // Rope length while oscillating.
+    float maxAngleDeg;        // Swing amplitude in degrees.
+    float periodMs;           // Duration of one full swing.
+    float droppingSpeed;      // Hook speed while dropping and rolling back (px/s).
+    float pullSpeed;          // Retract speed with a gold attached (px/s).
+    float timeLimit;          // Round length in seconds.
+    int target;               // Points needed to win the round.
+    int numGolds;
+    int numRocks;
+    char background[LEVEL_PATH_LEN];
+    int depth;                // Height of the mine; the camera scrolls below the first screen.
+    Uint32 mineSeed;          // Non-zero: everything below the first screen is generated from this seed.
+} LevelHeader;
+
+// A loaded level. header, golds and rocks all point into one block, so a
+// level costs exactly one allocation no matter how many objects it holds.
+typedef struct {
+    LevelHeader* header;
+    GoldObject* golds;
+    RockObject* rocks;
+    void* block;
+    size_t blockSize;
+    Arena* arena;             // The block's; NULL for the heap.
+} Level;
+
+// Allocates a level with room for the given objects and default tuning,
+// in `arena` (NULL for the heap). The objects themselves are left zeroed
+// for the caller to fill in.
+bool allocLevel(Level* level, int numGolds, int numRocks, Arena* arena);
+
+// A copy of `level` in `arena`, for playing it without touching the
+// original.
+bool copyLevel(const Level* level, Level* copy, Arena* arena);
+
+// Parses the human-editable text form (see levels/level1.txt).
+bool loadLevelText(const char* path, Level* level, Arena* arena);
+
+// Writes the text form of a loaded level.
+bool saveLevelText(const char* path, const Level* level);
+
+// Loads the compiled form with a single read into a single allocation.
+bool loadLevelBinary(const char* path, Level* level, Arena* arena);
+
+// Writes the compiled form of a loaded level.
+bool saveLevelBinary(const char* path, const Level* level);
+
+// Loads a ".lvl" file as binary and anything else as text.
+bool loadLevel(const char* path, Level* level, Arena* arena);
+
+// Writes the path of level number `index` (1-based) into `out`, preferring
+// the compiled file over the text one. Returns false if neither exists.
+bool findLevelFile(int index, char* out, size_t outSize);
+
+void freeLevel(Level* level);
+
+#endif // LEVEL_H
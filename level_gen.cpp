@@ -0,0 +1,401 @@
+#include "level_gen.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PI 3.14159265358979323846
+
+// Candidates tried around an active sample before it is retired. They are
+// spread evenly around the ring rather than at random, which packs about as
+// tightly as Bridson's usual 30 random tries at a fraction of the cost.
+#define GEN_ATTEMPTS 8
+
+// A grid cell is MAX_RADIUS wide, so it can hold at most four objects.
+#define CELL_SLOTS 4
+
+// Depth bands, by fraction of the band range (normally the field depth).
+// Shallow ground is sparse small stuff; deep ground is packed tighter with
+// the valuable pieces. Weights are per object kind; a kind left out is
+// never generated.
+typedef struct {
+    float until;
+    float gap;                // Extra clearance around each object.
+    int weights[NUM_OBJECT_KINDS];
+} DepthBand;
+
+static const DepthBand DEPTH_BANDS[] = {
+    {0.33f, 40.0f, {45, 10, 0, 5, 30, 10}},
+    {0.66f, 28.0f, {20, 30, 10, 10, 15, 15}},
+    {1.01f, 18.0f, {10, 20, 30, 15, 5, 20}},
+};
+#define NUM_DEPTH_BANDS 3
+
+// Largest clearance radius any object can have: half the diagonal of the
+// biggest kind plus half the widest gap. Also the grid cell size.
+static const float MAX_RADIUS = largestObjectSize() * 0.70710678f + 20.0f;
+static const float MIN_RADIUS = smallestObjectSize() * 0.70710678f + 9.0f;
+
+// xorshift32; small, fast and the same on every platform.
+static Uint32 nextRandom(Uint32* state) {
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static float randomUnit(Uint32* state) {
+    return (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Uniform in [0, n) without a division.
+static int randomBelow(Uint32* state, int n) {
+    return (int)(((Uint64)nextRandom(state) * (Uint32)n) >> 32);
+}
+
+static const DepthBand* bandAt(float depth) {
+    int b = 0;
+    while (b < NUM_DEPTH_BANDS - 1 && depth >= DEPTH_BANDS[b].until)
+        b++;
+    return &DEPTH_BANDS[b];
+}
+
+static int pickKind(const DepthBand* band, Uint32* rng) {
+    int total = 0;
+    for (int k = 0; k < NUM_OBJECT_KINDS; k++)
+        total += band->weights[k];
+    int roll = randomBelow(rng, total);
+    int k = 0;
+    while (roll >= band->weights[k]) {
+        roll -= band->weights[k];
+        k++;
+    }
+    return k;
+}
+
+// One grid cell. Unused slots sit far off the field with radius 0, so a
+// neighbour check can test all four slots without branching on the count.
+typedef struct {
+    float x[CELL_SLOTS];
+    float y[CELL_SLOTS];
+    float radius[CELL_SLOTS];
+    int count;
+} GenCell;
+
+// Working arrays for one run, all carved from a single allocation.
+typedef struct {
+    float* x;                 // Object centres.
+    float* y;
+    float* radius;            // Clearance radius; two objects keep radius sum apart.
+    unsigned char* kind;
+    int* active;              // Samples that may still spawn neighbours.
+    GenCell* cells;
+    int gridW, gridH;
+    int capacity;
+} GenScratch;
+
+static bool fits(const GenScratch* s, const LevelGenParams* params, float x, float y, float r) {
+    // Only cells within r plus the largest possible neighbour radius matter.
+    float reach = r + MAX_RADIUS;
+    float fy = y - params->top;
+    int x0 = x - reach > 0 ? (int)((x - reach) / MAX_RADIUS) : 0;
+    int y0 = fy - reach > 0 ? (int)((fy - reach) / MAX_RADIUS) : 0;
+    int x1 = (int)((x + reach) / MAX_RADIUS);
+    int y1 = (int)((fy + reach) / MAX_RADIUS);
+    if (x1 >= s->gridW) x1 = s->gridW - 1;
+    if (y1 >= s->gridH) y1 = s->gridH - 1;
+    for (int gy = y0; gy <= y1; gy++) {
+        const GenCell* row = &s->cells[gy * s->gridW];
+        int hit = 0;
+        for (int gx = x0; gx <= x1; gx++) {
+            const GenCell* c = &row[gx];
+            for (int i = 0; i < CELL_SLOTS; i++) {
+                float dx = c->x[i] - x, dy = c->y[i] - y, minDist = c->radius[i] + r;
+                hit |= dx * dx + dy * dy < minDist * minDist;
+            }
+        }
+        if (hit)
+            return false;
+    }
+    return true;
+}
+
+static int addSample(GenScratch* s, const LevelGenParams* params, int count, float x, float y, float r, int kind) {
+    s->x[count] = x;
+    s->y[count] = y;
+    s->radius[count] = r;
+    s->kind[count] = (unsigned char)kind;
+    GenCell* c = &s->cells[(int)((y - params->top) / MAX_RADIUS) * s->gridW + (int)(x / MAX_RADIUS)];
+    c->x[c->count] = x;
+    c->y[c->count] = y;
+    c->radius[c->count] = r;
+    c->count++;
+    return count + 1;
+}
+
+static bool insideField(const LevelGenParams* params, float x, float y, int size) {
+    float half = size * 0.5f;
+    return x - half >= 0 && x + half < params->width && y - half >= params->top && y + half < params->top + params->height;
+}
+
+static size_t layoutScratch(const LevelGenParams* params, GenScratch* s) {
+    s->gridW = (int)(params->width / MAX_RADIUS) + 1;
+    s->gridH = (int)(params->height / MAX_RADIUS) + 1;
+    // Densest possible packing of the smallest kind bounds the sample count.
+    s->capacity = (int)((double)params->width * params->height / (PI * MIN_RADIUS * MIN_RADIUS)) + 16;
+    size_t perSample = 3 * sizeof(float) + sizeof(int) + 1;
+    return (size_t)s->gridW * s->gridH * sizeof(GenCell) + s->capacity * perSample;
+}
+
+size_t levelGenScratchSize(const LevelGenParams* params) {
+    GenScratch s;
+    return layoutScratch(params, &s);
+}
+
+// Runs the sampler. On success the kept samples are s->active[0..*keep).
+// The working arrays go in `scratch` if it is given, otherwise *mem is set
+// to a new allocation for the caller to free.
+static bool sampleField(const LevelGenParams* params, GenScratch* s, void* scratch, char** mem, int* keep) {
+    *mem = NULL;
+    if (params->width <= 0 || params->height <= 0)
+        return false;
+    size_t size = layoutScratch(params, s);
+    char* base = (char*)scratch;
+    if (base == NULL) {
+        base = *mem = (char*)malloc(size);
+        if (base == NULL)
+            return false;
+    }
+    s->cells = (GenCell*)base;
+    s->x = (float*)(s->cells + s->gridW * s->gridH);
+    s->y = s->x + s->capacity;
+    s->radius = s->y + s->capacity;
+    s->active = (int*)(s->radius + s->capacity);
+    s->kind = (unsigned char*)(s->active + s->capacity);
+    for (int i = 0; i < s->gridW * s->gridH; i++) {
+        for (int k = 0; k < CELL_SLOTS; k++) {
+            s->cells[i].x[k] = -1e6f;
+            s->cells[i].y[k] = -1e6f;
+            s->cells[i].radius[k] = 0.0f;
+        }
+        s->cells[i].count = 0;
+    }
+
+    Uint32 rng = params->seed ? params->seed : 0x9E3779B9u;
+    int bandTop = params->bandHeight > 0 ? params->bandTop : params->top;
+    float invBandHeight = 1.0f / (params->bandHeight > 0 ? params->bandHeight : params->height);
+    int count = 0, numActive = 0;
+    // Seed the field with one object at a random spot in its top third.
+    for (int tries = 0; count == 0 && tries < 100; tries++) {
+        float x = randomUnit(&rng) * params->width;
+        float y = params->top + randomUnit(&rng) * params->height * 0.33f;
+        const DepthBand* band = bandAt((y - bandTop) * invBandHeight);
+        int kind = pickKind(band, &rng);
+        if (insideField(params, x, y, OBJECT_ARCHETYPES[kind].size)) {
+            count = addSample(s, params, count, x, y, OBJECT_ARCHETYPES[kind].size * 0.70710678f + band->gap * 0.5f, kind);
+            s->active[numActive++] = 0;
+        }
+    }
+    // Bridson's algorithm with per-object radii: try candidates in the ring
+    // just outside a random active object until one clears every neighbour.
+    const float stepCos = cosf((float)(2 * PI / GEN_ATTEMPTS));
+    const float stepSin = sinf((float)(2 * PI / GEN_ATTEMPTS));
+    while (numActive > 0 && count < s->capacity) {
+        int a = randomBelow(&rng, numActive);
+        int p = s->active[a];
+        const DepthBand* band = bandAt((s->y[p] - bandTop) * invBandHeight);
+        int kind = pickKind(band, &rng);
+        float r = OBJECT_ARCHETYPES[kind].size * 0.70710678f + band->gap * 0.5f;
+        float minDist = s->radius[p] + r;
+        float angle = randomUnit(&rng) * (float)(2 * PI);
+        float dirX = cosf(angle), dirY = sinf(angle);
+        bool placed = false;
+        for (int t = 0; t < GEN_ATTEMPTS && !placed; t++) {
+            float nextX = dirX * stepCos - dirY * stepSin;
+            dirY = dirX * stepSin + dirY * stepCos;
+            dirX = nextX;
+            float dist = minDist * (1.0f + 0.1f * randomUnit(&rng));
+            float x = s->x[p] + dist * dirX;
+            float y = s->y[p] + dist * dirY;
+            if (!insideField(params, x, y, OBJECT_ARCHETYPES[kind].size) || !fits(s, params, x, y, r))
+                continue;
+            s->active[numActive++] = count;
+            count = addSample(s, params, count, x, y, r, kind);
+            placed = true;
+        }
+        if (!placed)
+            s->active[a] = s->active[--numActive];
+    }
+
+    // Thin out to maxObjects with a partial shuffle, which keeps the
+    // survivors spread over the whole field rather than around the seed.
+    *keep = count;
+    int* order = s->active;   // No longer needed for sampling.
+    for (int i = 0; i < count; i++)
+        order[i] = i;
+    if (params->maxObjects > 0 && params->maxObjects < count) {
+        *keep = params->maxObjects;
+        for (int i = 0; i < *keep; i++) {
+            int j = i + randomBelow(&rng, count - i);
+            int tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+    }
+    return true;
+}
+
+static SDL_Rect sampleRect(const GenScratch* s, int n) {
+    int size = OBJECT_ARCHETYPES[s->kind[n]].size;
+    return (SDL_Rect){(int)(s->x[n] - size * 0.5f), (int)(s->y[n] - size * 0.5f), size, size};
+}
+
+bool generateLevel(const LevelGenParams* params, Level* level, Arena* arena) {
+    GenScratch s;
+    char* mem;
+    int keep;
+    if (!sampleField(params, &s, NULL, &mem, &keep))
+        return false;
+    int numGolds = 0, numRocks = 0;
+    for (int i = 0; i < keep; i++) {
+        if (OBJECT_ARCHETYPES[s.kind[s.active[i]]].isRock)
+            numRocks++;
+        else
+            numGolds++;
+    }
+    if (!allocLevel(level, numGolds, numRocks, arena)) {
+        free(mem);
+        return false;
+    }
+    int g = 0, r = 0;
+    for (int i = 0; i < keep; i++) {
+        int n = s.active[i];
+        ObjectKind kind = (ObjectKind)s.kind[n];
+        if (OBJECT_ARCHETYPES[kind].isRock) {
+            level->rocks[r].rect = sampleRect(&s, n);
+            level->rocks[r].type = kind;
+            level->rocks[r].active = true;
+            r++;
+        } else {
+            level->golds[g].rect = sampleRect(&s, n);
+            level->golds[g].type = kind;
+            level->golds[g].active = true;
+            g++;
+        }
+    }
+    free(mem);
+    if (params->top + params->height > level->header->depth)
+        level->header->depth = params->top + params->height;
+    level->header->target = estimateTargetScore(level);
+    return true;
+}
+
+bool generateObjects(const LevelGenParams* params, GoldObject* golds, int maxGolds, int* numGolds,
+                     RockObject* rocks, int maxRocks, int* numRocks, void* scratch) {
+    GenScratch s;
+    char* mem;
+    int keep;
+    *numGolds = 0;
+    *numRocks = 0;
+    if (!sampleField(params, &s, scratch, &mem, &keep))
+        return false;
+    for (int i = 0; i < keep; i++) {
+        int n = s.active[i];
+        ObjectKind kind = (ObjectKind)s.kind[n];
+        bool isRock = OBJECT_ARCHETYPES[kind].isRock;
+        if (isRock && *numRocks < maxRocks) {
+            rocks[*numRocks].rect = sampleRect(&s, n);
+            rocks[*numRocks].type = kind;
+            rocks[*numRocks].active = true;
+            (*numRocks)++;
+        } else if (!isRock && *numGolds < maxGolds) {
+            golds[*numGolds].rect = sampleRect(&s, n);
+            golds[*numGolds].type = kind;
+            golds[*numGolds].active = true;
+            (*numGolds)++;
+        }
+    }
+    free(mem);
+    return true;
+}
+
+bool generateEndlessLevel(int levelIndex, Level* level, Arena* arena) {
+    LevelGenParams params;
+    params.seed = (Uint32)levelIndex * 2654435761u;
+    params.width = 1366;
+    params.top = 280;
+    params.height = 768 - 280 - 20;
+    params.maxObjects = levelIndex + 12 < 40 ? levelIndex + 12 : 40;
+    params.bandTop = 0;
+    params.bandHeight = 0;
+    if (!generateLevel(&params, level, arena))
+        return false;
+    // The swing speeds up a little every level.
+    float period = 2000.0f - 40.0f * levelIndex;
+    level->header->periodMs = period > 1200.0f ? period : 1200.0f;
+    level->header->target = estimateTargetScore(level);
+    return true;
+}
+
+// One candidate grab for the target estimate.
+typedef struct {
+    float value;
+    float seconds;
+} Grab;
+
+static int compareGrabs(const void* a, const void* b) {
+    const Grab* ga = (const Grab*)a;
+    const Grab* gb = (const Grab*)b;
+    float ra = ga->value / ga->seconds, rb = gb->value / gb->seconds;
+    return (ra < rb) - (ra > rb);
+}
+
+// Works out how long grabbing an object at rect takes from the hook's rest
+// position, or returns false if the swing never points at it or it is too
+// deep to fetch within the time limit.
+static bool grabTime(const LevelHeader* h, const SDL_Rect* rect, float retractSpeed, float* seconds) {
+    float anchorX = h->charRect.x + h->charRect.w / 2.0f;
+    float anchorY = h->charRect.y + h->charRect.h / 2.0f;
+    float dx = rect->x + rect->w / 2.0f - anchorX;
+    float dy = rect->y + rect->h / 2.0f - anchorY;
+    if (dy <= 0 || fabsf(atan2f(dx, dy)) > h->maxAngleDeg * (float)(PI / 180.0))
+        return false;
+    float dist = sqrtf(dx * dx + dy * dy) - h->baseR;
+    // On average the player waits a quarter swing for the hook to line up.
+    *seconds = h->periodMs / 4000.0f + dist / h->droppingSpeed + dist / retractSpeed;
+    return *seconds <= h->timeLimit;
+}
+
+int estimateTargetScore(const Level* level) {
+    const LevelHeader* h = level->header;
+    int total = h->numGolds + h->numRocks;
+    Grab* grabs = (Grab*)malloc(sizeof(Grab) * (total > 0 ? total : 1));
+    if (grabs == NULL)
+        return h->target;
+    int n = 0;
+    for (int i = 0; i < h->numGolds; i++) {
+        ObjectKind kind = level->golds[i].type;
+        if (grabTime(h, &level->golds[i].rect, h->pullSpeed * OBJECT_ARCHETYPES[kind].retractScale, &grabs[n].seconds))
+            grabs[n++].value = expectedPoints(kind);
+    }
+    for (int i = 0; i < h->numRocks; i++) {
+        ObjectKind kind = level->rocks[i].type;
+        if (grabTime(h, &level->rocks[i].rect, h->pullSpeed * OBJECT_ARCHETYPES[kind].retractScale, &grabs[n].seconds))
+            grabs[n++].value = expectedPoints(kind);
+    }
+    // Greedy by points per second until the clock runs out.
+    qsort(grabs, n, sizeof(Grab), compareGrabs);
+    float timeLeft = h->timeLimit, best = 0.0f;
+    for (int i = 0; i < n && timeLeft > 0; i++) {
+        if (grabs[i].seconds <= timeLeft) {
+            best += grabs[i].value;
+            timeLeft -= grabs[i].seconds;
+        }
+    }
+    free(grabs);
+    // Ask for about 45% of that, in steps of 50 points; that puts the
+    // hand-made levels close to their authored targets.
+    int target = (int)(best * 0.45f / 50.0f + 0.5f) * 50;
+    return target > 50 ? target : 50;
+}
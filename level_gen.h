@@ -0,0 +1,45 @@
+#ifndef LEVEL_GEN_H
+#define LEVEL_GEN_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "level.h"
+
+// Parameters for a generated level. Objects are placed in the field
+// x in [0, width), y in [top, top + height).
+typedef struct {
+    Uint32 seed;
+    int width;
+    int top;                  // First row below the character (about 280).
+    int height;
+    int maxObjects;           // Keep at most this many, spread over the whole field (0 = fill it).
+    int bandTop;              // Depth bands span [bandTop, bandTop + bandHeight);
+    int bandHeight;           // 0 = the field itself.
+} LevelGenParams;
+
+// Places golds, mystery bags and rocks by Poisson-disk sampling. Each object
+// keeps a gap to its neighbours that depends on its depth band, and the mix
+// of kinds shifts towards big gold and big rocks further down. No two
+// objects overlap. The level gets default tuning and an estimated target,
+// and is allocated in `arena` (NULL for the heap).
+bool generateLevel(const LevelGenParams* params, Level* level, Arena* arena);
+
+// Same placement, written into caller-owned arrays instead of a new level.
+// Objects that do not fit in the arrays are dropped. `scratch` is working
+// memory of at least levelGenScratchSize(params) bytes, or NULL to allocate
+// it for this call.
+bool generateObjects(const LevelGenParams* params, GoldObject* golds, int maxGolds, int* numGolds,
+                     RockObject* rocks, int maxRocks, int* numRocks, void* scratch);
+
+// Working memory generateObjects needs for a field of this size.
+size_t levelGenScratchSize(const LevelGenParams* params);
+
+// Generated level used once the authored levels in levels/ run out.
+bool generateEndlessLevel(int levelIndex, Level* level, Arena* arena);
+
+// Estimates a fair target: the points a good player collects in the time
+// limit by grabbing the best value-per-second objects within the swing,
+// scaled down to leave room for misses.
+int estimateTargetScore(const Level* level);
+
+#endif // LEVEL_GEN_H
@@ -1,56 +1,152 @@
 #include <SDL.h>                              // Main SDL header (graphics, events, etc.)
 #include <SDL_image.h>                        // SDL_image for image loading
-#include <SDL_ttf.h>                          // SDL_ttf for fonts
 #include <SDL_mixer.h>                        // SDL_mixer for audio
 #include <stdio.h>                            // Standard I/O
 #include <stdbool.h>                          // Boolean support
 #include <math.h>                             // Math functions (sin, cos, etc.)
 #include <stdlib.h>                           // Standard library (rand, srand, etc.)
 #include <time.h>                             // Time functions (for seeding RNG)
+#include <string.h>                           // String functions (strcmp)
 #include "objects.h"                          // Include objects definitions
 #include "high_scores.h"                      // Include high scores functions
+#include "level.h"                            // Level loading
+#include "preload.h"                          // Background loading of the next round
+#include "sequence.h"                         // Per-frame coroutine sequences
+#include "mine.h"                             // Chunk streaming for deep mines
+#include "sfx.h"                              // Sound effects
+#include "render_scale.h"                     // Dynamic internal resolution
+#include "input.h"                            // Timestamped player input
+#include "game.h"                             // Round simulation
+#include "sim_thread.h"                       // The round's simulation thread
+#include "particles.h"                        // Explosion particles
+#include "text_atlas.h"                       // Prerendered text
+#include "alloc_track.h"                      // Allocation counting
+#include "net.h"                              // Two-player lockstep over UDP
+#include "telemetry.h"                        // Binary event log
+#include "metrics.h"                          // Live metrics for the floor monitor
+#include "perf_counters.h"                    // Hardware counters per loop phase
+#include "assets.h"                           // Gameplay assets, loaded behind the menu
+#include "soft_raster.h"                      // CPU playfield renderer
+#include "arena.h"                            // Per-round memory
 
 #define PI 3.14159265358979323846             // Define PI constant
 
-// Define hook states (if additional hook functions are not split yet, we define them here)
-typedef enum { OSCILLATING, PULLING_DOWN, ROLLING_BACK, PULLING_GOLD, dynamite_MOVING, dynamite_EXPLOSION } HookState;
-
 // Forward declarations for menu and UI functions.
-int runMenu(SDL_Renderer* renderer, TTF_Font* font);
-void showControls(SDL_Renderer* renderer, TTF_Font* font);
-void showTargetScreen(SDL_Renderer* renderer, TTF_Font* font48, SDL_Texture* targetTexture, Mix_Music* targetMusic, int neededPoints);
+int runMenu(SDL_Renderer* renderer, const TextAtlas* text, GameAssets* assets);
+void showControls(SDL_Renderer* renderer, const TextAtlas* text);
+bool runScreen(SDL_Renderer* renderer, Sequence screen);
+Sequence targetScreen(SDL_Renderer* renderer, const TextAtlas* bigText, SDL_Texture* targetTexture, Mix_Music* targetMusic, RoundPreload* preload);
+Sequence resultScreen(SDL_Renderer* renderer, SDL_Texture* resultTexture, RoundPreload* preload);
+
+// Draws a playfield image through the soft raster when it is running, or
+// else with SDL, which takes the tint from the texture's colour mod.
+static void drawPlayfieldImage(Raster* raster, SDL_Renderer* renderer, SDL_Texture* texture, const RasterImage* image,
+                               const SDL_Rect* src, const SDL_Rect* dst, Uint8 tint) {
+    if (raster->target)
+        rasterCopy(raster, image, src, dst, (SDL_Color){tint, tint, 255, 255});
+    else
+        SDL_RenderCopy(renderer, texture, src, dst);
+}
+
+// The hook or dynamite at `angleDeg`, from the pre-turned frames. Returns
+// false, drawing nothing, when there is no frame to draw.
+static bool drawPlayfieldHook(Raster* raster, SDL_Renderer* renderer, const GameAssets* assets, HookSprite sprite,
+                              const SDL_Rect* dst, SDL_Point pivot, float angleDeg, Uint8 tint) {
+    if (!raster->target)
+        return drawRotatedSprite(&assets->hookSprites[sprite], renderer, dst, pivot, angleDeg);
+    const RotatedFrame* frame = findRotatedFrame(&assets->hookSprites[sprite], angleDeg);
+    if (!frame)
+        return false;
+    SDL_Rect r = {dst->x + pivot.x + frame->offset.x, dst->y + pivot.y + frame->offset.y, frame->src.w, frame->src.h};
+    rasterCopy(raster, &assets->hookImages[sprite], &frame->src, &r, (SDL_Color){tint, tint, 255, 255});
+    return true;
+}
+
+// Start of main(), until the first menu frame is on screen.
+static Uint64 launchTime;
 
 int main(int argc, char* argv[]) {
+    launchTime = SDL_GetPerformanceCounter();
     srand((unsigned int)time(NULL)); // Seed random number generator
+    // "--audio-buffer <frames>" trades latency for robustness on slow machines.
+    // "--frame-budget <ms>" sets the frame time the resolution scaler aims for.
+    // "--host <port>" and "--join <address> <port>" start a two-player game.
+    // "--alloc-stats" counts allocations per gameplay frame and checks that
+    // none happen after warm-up.
+    // "--no-telemetry" turns off the event log (telemetry*.bin).
+    // "--perf-counters" reports hardware counters per session loop phase
+    // (Linux only).
+    // "--soft-raster" draws on the CPU into the window surface, with the
+    // playfield on the SIMD rasterizer (for machines without a GPU).
+    // "--record <prefix>" saves each finished round's inputs as
+    // <prefix><time>.rep, for tools/replaycheck.cpp to verify the score.
+    int audioBuffer = SFX_DEFAULT_BUFFER;
+    float frameBudget = SCALE_DEFAULT_BUDGET_MS;
+    int hostPort = 0, joinPort = 0;
+    const char* joinAddress = NULL;
+    bool allocStats = false;
+    bool telemetry = true;
+    bool perfCounters = false;
+    bool softRaster = false;
+    const char* replayPrefix = NULL;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--audio-buffer") == 0 && hasValue)
+            audioBuffer = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--frame-budget") == 0 && hasValue)
+            frameBudget = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--host") == 0 && hasValue)
+            hostPort = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--join") == 0 && i + 2 < argc) {
+            joinAddress = argv[i + 1];
+            joinPort = atoi(argv[i + 2]);
+        } else if (strcmp(argv[i], "--alloc-stats") == 0)
+            allocStats = true;
+        else if (strcmp(argv[i], "--no-telemetry") == 0)
+            telemetry = false;
+        else if (strcmp(argv[i], "--perf-counters") == 0)
+            perfCounters = true;
+        else if (strcmp(argv[i], "--soft-raster") == 0)
+            softRaster = true;
+        else if (strcmp(argv[i], "--record") == 0 && hasValue)
+            replayPrefix = argv[i + 1];
+    }
+    if (allocStats)
+        startAllocTracking(); // Must come before SDL allocates anything
     if (SDL_Init(SDL_INIT_VIDEO) < 0) { // Initialize SDL video subsystem
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return 1;
     }
-    if (TTF_Init() == -1) { // Initialize SDL_ttf
-        printf("TTF_Init: %s\n", TTF_GetError());
+    if (telemetry)
+        startTelemetry("telemetry"); // The game runs on without it
+    openMetrics(); // Likewise
+    if (perfCounters)
+        perfCounters = openPerfCounters();
+    SdfFont font; // Every size of text is drawn from this (see tools/fontbake.cpp)
+    if (!loadSdfFont("arial.sdf", &font)) {
         SDL_Quit();
         return 1;
     }
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) { // Initialize SDL_mixer
-        printf("SDL_mixer could not initialize! Mix_Error: %s\n", Mix_GetError());
-        return 1;
-    }
-    TTF_Font* font = TTF_OpenFont("arial.ttf", 24); // Load 24pt font
-    if (!font) {
-        printf("Failed to load font (24pt): %s\n", TTF_GetError());
-        return 1;
-    }
-    TTF_Font* font48 = TTF_OpenFont("arial.ttf", 48); // Load 48pt font
-    if (!font48) {
-        printf("Failed to load font (48pt): %s\n", TTF_GetError());
-        return 1;
-    }
     SDL_Window* window = SDL_CreateWindow("Đào vàng", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1366, 768, SDL_WINDOW_SHOWN); // Create window
     if (!window) {
         printf("Window error: %s\n", SDL_GetError());
         return 1;
     }
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED); // Create renderer
+    // With --soft-raster, SDL's software renderer and the raster share the
+    // window surface; if either cannot start, the usual renderer takes over.
+    Raster raster = {};
+    SDL_Renderer* renderer = NULL;
+    if (softRaster) {
+        SDL_Surface* windowSurface = SDL_GetWindowSurface(window);
+        if (windowSurface && initRaster(&raster, windowSurface, 0))
+            renderer = SDL_CreateSoftwareRenderer(windowSurface);
+        if (!renderer) {
+            printf("Soft raster unavailable, using the default renderer\n");
+            freeRaster(&raster);
+        }
+    }
+    if (!renderer)
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED); // Create renderer
     if (!renderer) {
         printf("Renderer error: %s\n", SDL_GetError());
         SDL_DestroyWindow(window);
@@ -63,460 +159,419 @@ int main(int argc, char* argv[]) {
         SDL_DestroyWindow(window);
         return 1;
     }
-    // Load common assets.
-    SDL_Surface* bgSurface = IMG_Load("background.png");
-    SDL_Texture* bgTexture = SDL_CreateTextureFromSurface(renderer, bgSurface);
-    SDL_FreeSurface(bgSurface);
-    SDL_Surface* charSurface = IMG_Load("character.png");
-    SDL_Texture* charTexture = SDL_CreateTextureFromSurface(renderer, charSurface);
-    SDL_FreeSurface(charSurface);
-    SDL_Surface* goldSurface = IMG_Load("gold.png");
-    SDL_Texture* goldTexture = SDL_CreateTextureFromSurface(renderer, goldSurface);
-    SDL_FreeSurface(goldSurface);
-    SDL_Surface* hookSurface = IMG_Load("hook.png");
-    SDL_Texture* hookTexture = SDL_CreateTextureFromSurface(renderer, hookSurface);
-    SDL_FreeSurface(hookSurface);
-    SDL_Surface* rockSurface = IMG_Load("rock.png");
-    SDL_Texture* rockTexture = SDL_CreateTextureFromSurface(renderer, rockSurface);
-    SDL_FreeSurface(rockSurface);
-    SDL_Surface* dynamiteSurface = IMG_Load("dynamite.png");
-    if (!dynamiteSurface)
-        printf("Error loading dynamite.png: %s\n", IMG_GetError());
-    SDL_Texture* dynamiteTexture = SDL_CreateTextureFromSurface(renderer, dynamiteSurface);
-    SDL_FreeSurface(dynamiteSurface);
-    SDL_Surface* implodeSurface = IMG_Load("explosion.png");
-    if (!implodeSurface)
-        printf("Error loading explosion.png: %s\n", IMG_GetError());
-    SDL_Texture* implodeTexture = SDL_CreateTextureFromSurface(renderer, implodeSurface);
-    SDL_FreeSurface(implodeSurface);
-    SDL_Surface* mysbagSurface = IMG_Load("mysbag.png");
-    if (!mysbagSurface)
-        printf("Error loading mysbag.png: %s\n", IMG_GetError());
-    SDL_Texture* mysbagTexture = SDL_CreateTextureFromSurface(renderer, mysbagSurface);
-    SDL_FreeSurface(mysbagSurface);
-    SDL_Surface* successSurface = IMG_Load("success.png");
-    if (!successSurface)
-        printf("Error loading success.png: %s\n", IMG_GetError());
-    SDL_Texture* successTexture = SDL_CreateTextureFromSurface(renderer, successSurface);
-    SDL_FreeSurface(successSurface);
-    SDL_Surface* failureSurface = IMG_Load("failure.png");
-    if (!failureSurface)
-        printf("Error loading failure.png: %s\n", IMG_GetError());
-    SDL_Texture* failureTexture = SDL_CreateTextureFromSurface(renderer, failureSurface);
-    SDL_FreeSurface(failureSurface);
-    SDL_Surface* targetSurface = IMG_Load("Target.png");
-    if (!targetSurface)
-        printf("Error loading Target.png: %s\n", IMG_GetError());
-    SDL_Texture* targetTexture = SDL_CreateTextureFromSurface(renderer, targetSurface);
-    SDL_FreeSurface(targetSurface);
-    Mix_Music* targetMusic = Mix_LoadMUS("target.mp3");
-    if (!targetMusic)
-        printf("Error loading target.mp3: %s\n", Mix_GetError());
+    // Only the menu's own font and background are loaded up front; the
+    // rest comes in while the menu is showing.
+    GameAssets assets;
+    startGameAssets(&assets, audioBuffer, &font, raster.target != NULL);
+    TextAtlas hudText; // The 24pt font, for the HUD and the menus
+    initTextAtlas(&hudText, renderer, &font, 24);
+    RenderScaler scaler = {};
+    if (!raster.target) // The raster always draws at full size, straight to the window
+        initRenderScaler(&scaler, renderer, 1366, 768, frameBudget);
+    Particles particles;
+    initParticles(&particles);
+    NetSession net;
+    bool versus = false;
+    if (hostPort > 0)
+        versus = hostNetSession(&net, hostPort);
+    else if (joinAddress != NULL)
+        versus = joinNetSession(&net, joinAddress, joinPort);
     // Main session loop.
     bool exitProgram = false;
+    // Each round's level, mine tables and raster background live in an
+    // arena that is reset when the round ends. There are two, taken in
+    // turn, because the next round loads while this one's result is up.
+    static Arena roundArenas[2];
+    for (int i = 0; i < 2; i++)
+        initArena(&roundArenas[i], SESSION_ARENA_BYTES); // On failure everything overflows to the heap
+    int nextArena = 0;
+    RoundPreload preload;
+    startRoundPreload(&preload, 1, raster.target != NULL, &roundArenas[nextArena++ & 1]); // First round loads while the menu is up
     while (!exitProgram) {
-        int menuResult = runMenu(renderer, font); // Display main menu
+        setMetricsScreen(SCREEN_MENU);
+        int menuResult = runMenu(renderer, &hudText, &assets); // Display main menu
         if (menuResult == 1) { // If quit signal from menu
             exitProgram = true;
             break;
         }
-        // Display target screen each time "Begin" is pressed
-        showTargetScreen(renderer, font48, targetTexture, targetMusic, 400);
+        // Display target screen each time "Begin" is pressed; the round
+        // finishes loading behind it.
+        setMetricsScreen(SCREEN_TARGET);
+        finishGameAssets(&assets, renderer);
+        SDL_Texture** textures = assets.textures;
+        if (!runScreen(renderer, targetScreen(renderer, &assets.bigText, textures[TEX_TARGET], assets.targetMusic, &preload))) {
+            exitProgram = true;
+            break;
+        }
+        RoundData round;
+        if (!finishRoundPreload(&preload, renderer, &round))
+            break;
+        setMetricsRoundLoad((float)(preload.readyTicks - preload.startTicks));
+        const LevelHeader* tuning = round.level.header;
+        SDL_Texture* bgTexture = round.background;
         // Initialize game session variables.
-        SDL_Rect charRect = {583, 90, 200, 100};
-        GoldObject golds[NUM_GOLDS];
-        golds[0].type = GOLD_SMALL;  golds[0].rect = (SDL_Rect){50,300,20,20};   golds[0].active = true;
-        golds[1].type = GOLD_SMALL;  golds[1].rect = (SDL_Rect){1250,320,20,20};  golds[1].active = true;
-        golds[2].type = GOLD_SMALL;  golds[2].rect = (SDL_Rect){350,340,20,20};   golds[2].active = true;
-        golds[3].type = GOLD_SMALL;  golds[3].rect = (SDL_Rect){600,360,20,20};   golds[3].active = true;
-        golds[4].type = GOLD_SMALL;  golds[4].rect = (SDL_Rect){900,280,20,20};   golds[4].active = true;
-        golds[5].type = GOLD_MEDIUM; golds[5].rect = (SDL_Rect){500,520,30,30};   golds[5].active = true;
-        golds[6].type = GOLD_MEDIUM; golds[6].rect = (SDL_Rect){1150,640,30,30};  golds[6].active = true;
-        golds[7].type = GOLD_MEDIUM; golds[7].rect = (SDL_Rect){800,700,30,30};   golds[7].active = true;
-        golds[8].type = GOLD_BIG;    golds[8].rect = (SDL_Rect){450,600,60,60};   golds[8].active = true;
-        golds[9].type = GOLD_BIG;    golds[9].rect = (SDL_Rect){1000,690,60,60};  golds[9].active = true;
-        golds[10].type = GOLD_MYSTERY; golds[10].rect = (SDL_Rect){400,450,40,40};  golds[10].active = true;
-        RockObject rocks[NUM_ROCKS];
-        rocks[0].type = ROCK_BIG;   rocks[0].rect = (SDL_Rect){250,370,50,50};   rocks[0].active = true;
-        rocks[1].type = ROCK_BIG;   rocks[1].rect = (SDL_Rect){550,380,50,50};   rocks[1].active = true;
-        rocks[2].type = ROCK_SMALL; rocks[2].rect = (SDL_Rect){900,320,30,30};   rocks[2].active = true;
-        rocks[3].type = ROCK_SMALL; rocks[3].rect = (SDL_Rect){1050,340,30,30};  rocks[3].active = true;
-        float anchorX = charRect.x + charRect.w/2.0f;
-        float anchorY = charRect.y + charRect.h/2.0f;
-        float baseR = 70.0f;
-        float maxAngle = 75.0f * (PI / 180.0f);
-        float period = 2000.0f;
-        float omega = 2*PI/(period/1000.0f);
-        HookState hookState = OSCILLATING;
-        Uint32 refTime = SDL_GetTicks();
-        float currentAngle = 0.0f, storedAngle = 0.0f, currentR = baseR;
-        float pullSpeed = 200.0f;
-        float droppingSpeed = 1000.0f;
-        float phaseOffset = 0.0f;
-        float hookX, hookY;
-        float scaleFactor = 0.05f;
-        int hookW = (int)(928 * scaleFactor);
-        int hookH = (int)(665 * scaleFactor);
-        hookX = anchorX; hookY = anchorY + baseR;
-        SDL_Point hookPivot = {(int)(465 * scaleFactor + 0.5f), (int)(77 * scaleFactor + 0.5f)};
-        SDL_Rect hookCollision;
-        hookCollision.w = 20; hookCollision.h = 20;
-        int score = 0;
-        bool isPullingRock = false;
-        int pulledGoldIndex = -1, pulledRockIndex = -1;
-        float dynamiteMoveTimeRemaining = 0.0f;
-        float explosionTimeRemaining = 0.0f;
-        float explosionX = 0.0f, explosionY = 0.0f;
-        int availabledynamites = 0;
-        float gameTimer = 60.0f;
-        bool timeUp = false;
-        bool quitSession = false;
-        Uint32 lastTime = SDL_GetTicks();
-        while (!quitSession) { // Game session loop
+        Mine mine;
+        if (!initMine(&mine, &round.level, round.arena)) {
+            freeRoundData(&round);
+            break;
+        }
+        // In a versus round both machines meet here and agree on the seed
+        // and the start time of tick 0.
+        Uint32 seed = (Uint32)rand();
+        Uint32 startTicks = SDL_GetTicks();
+        if (versus && syncNetRound(&net, (Uint16)round.levelIndex)) {
+            seed = net.roundSeed;
+            startTicks = net.startTicks;
+        } else if (versus) {
+            printf("Lost the other player; playing on alone\n");
+            closeNetSession(&net);
+            versus = false;
+        }
+        int localPlayer = versus ? net.localPlayer : 0;
+        Game game;
+        initGame(&game, tuning, &mine, versus ? 2 : 1, seed);
+        int bgW = VIEW_WIDTH, bgH = VIEW_HEIGHT;
+        SDL_QueryTexture(bgTexture, NULL, NULL, &bgW, &bgH);
+        // The simulation runs on its own thread from here on; this one
+        // handles the window and draws the newest view it published.
+        static SimThread sim; // Static: it is too big for the stack
+        static Replay replay; // Likewise
+        if (replayPrefix)
+            beginReplay(&replay, round.levelIndex, &round.level, seed, game.numPlayers, localPlayer);
+        if (!startSimThread(&sim, &game, versus ? &net : NULL, localPlayer, startTicks, perfCounters,
+                            replayPrefix ? &replay : NULL)) {
+            freeMine(&mine);
+            freeRoundData(&round);
+            break;
+        }
+        const FrameView* view = latestFrameView(&sim);
+        HookState soundState = view->players[localPlayer].hookState; // State the sound effects last reacted to
+        int soundRewinds = 0;
+        HookState effectStates[MAX_PLAYERS]; // Per player, to start explosions
+        for (int i = 0; i < view->numPlayers; i++)
+            effectStates[i] = view->players[i].hookState;
+        clearParticles(&particles);
+        FrameAllocStats frameAllocs;
+        resetFrameAllocs(&frameAllocs);
+        Uint64 lastFrame = SDL_GetPerformanceCounter();
+        Uint64 renderStart = lastFrame, renderBusy = 0;
+        setMetricsScreen(SCREEN_SESSION);
+        while (!view->timeUp) { // Game session loop
+            beginPerfPhase(PERF_EVENTS);
+            Uint64 frameStart = SDL_GetPerformanceCounter();
+            if (allocStats)
+                beginFrameAllocs(&frameAllocs);
+            float frameDt = (float)(frameStart - lastFrame) / SDL_GetPerformanceFrequency();
+            lastFrame = frameStart;
+            setTelemetryTime(SDL_GetTicks());
+            if (frameDt * 1000000.0f > TELEMETRY_SPIKE_US)
+                logTelemetry(TELEMETRY_FRAME_SPIKE, view->tick, localPlayer, 0, (int)(frameDt * 1000000.0f), 0);
+            // Key presses go to the simulation with their timestamps, which
+            // decide the tick they land in.
             SDL_Event event;
             while (SDL_PollEvent(&event)) {
                 if (event.type == SDL_QUIT) {
+                    stopSimThread(&sim);
+                    if (versus)
+                        closeNetSession(&net);
+                    freeParticles(&particles);
+                    freeRenderScaler(&scaler);
+                    freeTextAtlas(&hudText);
+                    freeGameAssets(&assets);
                     SDL_DestroyRenderer(renderer);
+                    freeRaster(&raster);
                     SDL_DestroyWindow(window);
-                    TTF_CloseFont(font);
-                    TTF_CloseFont(font48);
-                    Mix_CloseAudio();
+                    freeSdfFont(&font);
                     IMG_Quit();
-                    TTF_Quit();
+                    stopTelemetry();
+                    closeMetrics();
+                    printPerfPhases("Perf counters, whole run", true);
+                    closePerfCounters();
                     SDL_Quit();
                     exit(0);
                 }
-                if (event.type == SDL_KEYDOWN) {
-                    if (event.key.keysym.sym == SDLK_DOWN && !timeUp) {
-                        if (hookState == OSCILLATING) {
-                            hookState = PULLING_DOWN;
-                            storedAngle = currentAngle;
-                        }
-                    }
-                    if (event.key.keysym.sym == SDLK_UP && !timeUp) {
-                        if (hookState == PULLING_GOLD && availabledynamites > 0) {
-                            if ((!isPullingRock && pulledGoldIndex != -1) ||
-                                (isPullingRock && pulledRockIndex != -1)) {
-                                hookState = dynamite_MOVING;
-                                dynamiteMoveTimeRemaining = 0.05f;
-                                explosionX = hookX;
-                                explosionY = hookY;
-                                if (!isPullingRock && pulledGoldIndex != -1)
-                                    golds[pulledGoldIndex].active = false;
-                                else if (isPullingRock && pulledRockIndex != -1)
-                                    rocks[pulledRockIndex].active = false;
-                                availabledynamites--;
-                            }
-                        }
-                    }
-                }
+                if (event.type != SDL_KEYDOWN || event.key.repeat)
+                    continue;
+                SimCommand command = {};
+                command.timestamp = event.key.timestamp;
+                // R goes back five seconds. Only alone: the other player
+                // could not follow.
+                if (event.key.keysym.sym == SDLK_r && !versus)
+                    command.rewind = true;
+                else if (event.key.keysym.sym == SDLK_DOWN)
+                    command.kind = INPUT_RELEASE;
+                else if (event.key.keysym.sym == SDLK_UP)
+                    command.kind = INPUT_DYNAMITE;
+                else
+                    continue;
+                sendSimCommand(&sim, &command);
             }
-            Uint32 currentTime = SDL_GetTicks();
-            float deltaTime = (currentTime - lastTime) / 1000.0f;
-            lastTime = currentTime;
-            if (!timeUp) {
-                gameTimer -= deltaTime;
-                if (gameTimer <= 0) {
-                    gameTimer = 0;
-                    timeUp = true;
-                    break;
-                }
+            beginPerfPhase(PERF_UPDATE);
+            view = latestFrameView(&sim);
+            const PlayerState* me = &view->players[localPlayer];
+            // Every player's dynamite throws out particles when it goes off.
+            for (int i = 0; i < view->numPlayers; i++) {
+                const PlayerState* p = &view->players[i];
+                if (p->hookState == dynamite_EXPLOSION && effectStates[i] != dynamite_EXPLOSION)
+                    spawnExplosion(&particles, p->explosionX, p->explosionY);
+                effectStates[i] = p->hookState;
             }
-            anchorX = charRect.x + charRect.w / 2.0f;
-            anchorY = charRect.y + charRect.h / 2.0f;
-            if (!timeUp) {
-                switch (hookState) {
-                    case OSCILLATING: {
-                        float t = (currentTime - refTime) / 1000.0f;
-                        currentAngle = maxAngle * sin(omega * t + phaseOffset);
-                        currentR = baseR;
-                        hookX = anchorX + currentR * sin(currentAngle);
-                        hookY = anchorY + currentR * cos(currentAngle);
-                        break;
-                    }
-                    case PULLING_DOWN: {
-                        currentR += droppingSpeed * deltaTime;
-                        hookX = anchorX + currentR * sin(storedAngle);
-                        hookY = anchorY + currentR * cos(storedAngle);
-                        if (hookY + hookH/2 >= 768 || hookX - hookW/2 <= 0 || hookX + hookW/2 >= 1366)
-                            hookState = ROLLING_BACK;
-                        break;
-                    }
-                    case ROLLING_BACK: {
-                        currentR -= droppingSpeed * deltaTime;
-                        hookX = anchorX + currentR * sin(storedAngle);
-                        hookY = anchorY + currentR * cos(storedAngle);
-                        if (currentR <= baseR + 1.0f) {
-                            currentR = baseR;
-                            phaseOffset = asin(storedAngle / maxAngle);
-                            refTime = currentTime;
-                            hookState = OSCILLATING;
-                        }
-                        break;
-                    }
-                    case PULLING_GOLD: {
-                        float retractSpeed = isPullingRock ? pullSpeed * 0.5f : pullSpeed;
-                        currentR -= retractSpeed * deltaTime;
-                        hookX = anchorX + currentR * sin(storedAngle);
-                        hookY = anchorY + currentR * cos(storedAngle);
-                        SDL_Rect hookRect;
-                        hookRect.x = (int)hookX - hookW/2;
-                        hookRect.y = (int)hookY - hookH/2;
-                        hookRect.w = hookW;
-                        hookRect.h = hookH;
-                        int hookCenterX = hookRect.x + hookPivot.x;
-                        int hookCenterY = hookRect.y + hookPivot.y;
-                        if (!isPullingRock && pulledGoldIndex != -1) {
-                            golds[pulledGoldIndex].rect.x = hookCenterX - golds[pulledGoldIndex].rect.w/2;
-                            golds[pulledGoldIndex].rect.y = hookCenterY - golds[pulledGoldIndex].rect.h/2;
-                        } else if (isPullingRock && pulledRockIndex != -1) {
-                            rocks[pulledRockIndex].rect.x = hookCenterX - rocks[pulledRockIndex].rect.w/2;
-                            rocks[pulledRockIndex].rect.y = hookCenterY - rocks[pulledRockIndex].rect.h/2;
-                        }
-                        if (currentR <= baseR + 1.0f) {
-                            currentR = baseR;
-                            hookState = OSCILLATING;
-                            phaseOffset = asin(storedAngle / maxAngle);
-                            refTime = currentTime;
-                            if (!isPullingRock && pulledGoldIndex != -1) {
-                                if (golds[pulledGoldIndex].type == GOLD_MYSTERY) {
-                                    int r = rand() % 100;
-                                    if (r < 30)
-                                        availabledynamites++;
-                                    else if (r < 90)
-                                        score += 100;
-                                    else
-                                        score += 250;
-                                } else if (golds[pulledGoldIndex].type == GOLD_SMALL)
-                                    score += 50;
-                                else if (golds[pulledGoldIndex].type == GOLD_MEDIUM)
-                                    score += 100;
-                                else
-                                    score += 200;
-                                golds[pulledGoldIndex].active = false;
-                                pulledGoldIndex = -1;
-                            } else if (isPullingRock && pulledRockIndex != -1) {
-                                score += (rocks[pulledRockIndex].type == ROCK_SMALL) ? 10 : 20;
-                                rocks[pulledRockIndex].active = false;
-                                pulledRockIndex = -1;
-                            }
-                            printf("Score: %d\n", score);
-                        }
-                        break;
-                    }
-                    case dynamite_MOVING: {
-                        dynamiteMoveTimeRemaining -= deltaTime;
-                        if (dynamiteMoveTimeRemaining <= 0) {
-                            hookState = dynamite_EXPLOSION;
-                            explosionTimeRemaining = 0.2f;
-                        }
-                        break;
-                    }
-                    case dynamite_EXPLOSION: {
-                        explosionTimeRemaining -= deltaTime;
-                        if (explosionTimeRemaining <= 0) {
-                            currentR = baseR;
-                            phaseOffset = asin(storedAngle / maxAngle);
-                            refTime = currentTime;
-                            hookState = OSCILLATING;
-                            pulledGoldIndex = -1;
-                            pulledRockIndex = -1;
-                        }
-                        break;
-                    }
-                }
+            updateParticles(&particles, frameDt < 0.1f ? frameDt : 0.1f);
+            // Sound effects follow the local hook's state changes, and
+            // start over from its state after going back in time.
+            HookState hookState = me->hookState;
+            if (view->rewinds != soundRewinds) {
+                soundRewinds = view->rewinds;
+                stopAllSfx();
+                soundState = hookState;
+                if (soundState == PULLING_GOLD || soundState == ROLLING_BACK)
+                    playSfx(SFX_RETRACT, true);
             }
-            SDL_Rect hookRect;
-            hookRect.x = (int)hookX - hookW/2;
-            hookRect.y = (int)hookY - hookH/2;
-            hookRect.w = hookW;
-            hookRect.h = hookH;
-            hookCollision.x = (int)hookX - hookCollision.w/2;
-            hookCollision.y = (int)hookY - hookCollision.h/2;
-            int hookCenterX = hookRect.x + hookPivot.x;
-            int hookCenterY = hookRect.y + hookPivot.y;
-            if (!timeUp && hookState == PULLING_DOWN) {
-                float bestDist = 1e9f;
-                bool found = false;
-                int bestIndex = -1;
-                bool bestIsRock = false;
-                for (int i = 0; i < NUM_GOLDS; i++) {
-                    if (golds[i].active && SDL_HasIntersection(&hookCollision, &golds[i].rect)) {
-                        int objCenterX = golds[i].rect.x + golds[i].rect.w/2;
-                        int objCenterY = golds[i].rect.y + golds[i].rect.h/2;
-                        float dx = (float)(objCenterX - hookCenterX);
-                        float dy = (float)(objCenterY - hookCenterY);
-                        float dist = dx * dx + dy * dy;
-                        if (dist < bestDist) {
-                            bestDist = dist;
-                            bestIndex = i;
-                            bestIsRock = false;
-                            found = true;
-                        }
-                    }
-                }
-                for (int i = 0; i < NUM_ROCKS; i++) {
-                    if (rocks[i].active && SDL_HasIntersection(&hookCollision, &rocks[i].rect)) {
-                        int objCenterX = rocks[i].rect.x + rocks[i].rect.w/2;
-                        int objCenterY = rocks[i].rect.y + rocks[i].rect.h/2;
-                        float dx = (float)(objCenterX - hookCenterX);
-                        float dy = (float)(objCenterY - hookCenterY);
-                        float dist = dx * dx + dy * dy;
-                        if (dist < bestDist) {
-                            bestDist = dist;
-                            bestIndex = i;
-                            bestIsRock = true;
-                            found = true;
-                        }
-                    }
-                }
-                if (found) {
-                    hookState = PULLING_GOLD;
-                    if (bestIsRock) {
-                        isPullingRock = true;
-                        pulledRockIndex = bestIndex;
-                    } else {
-                        isPullingRock = false;
-                        pulledGoldIndex = bestIndex;
-                    }
-                }
+            if (hookState != soundState) {
+                bool wasWinding = soundState == PULLING_GOLD || soundState == ROLLING_BACK;
+                bool winding = hookState == PULLING_GOLD || hookState == ROLLING_BACK;
+                if (wasWinding && !winding)
+                    stopSfx(SFX_RETRACT);
+                if (hookState == PULLING_GOLD && soundState == PULLING_DOWN)
+                    playSfx(SFX_GRAB, false);
+                if (winding && !wasWinding)
+                    playSfx(SFX_RETRACT, true);
+                if (hookState == OSCILLATING && soundState == PULLING_GOLD)
+                    playSfx(SFX_SCORE, false);
+                if (hookState == dynamite_MOVING)
+                    playSfx(SFX_DYNAMITE, false);
+                if (hookState == dynamite_EXPLOSION)
+                    playSfx(SFX_EXPLOSION, false);
+                soundState = hookState;
             }
-            SDL_RenderClear(renderer);
-            if (!timeUp) {
-                SDL_RenderCopy(renderer, bgTexture, NULL, NULL);
-                for (int i = 0; i < NUM_GOLDS; i++) {
-                    if (golds[i].active) {
-                        if (golds[i].type == GOLD_MYSTERY)
-                            SDL_RenderCopy(renderer, mysbagTexture, NULL, &golds[i].rect);
-                        else
-                            SDL_RenderCopy(renderer, goldTexture, NULL, &golds[i].rect);
-                    }
-                }
-                for (int i = 0; i < NUM_ROCKS; i++) {
-                    if (rocks[i].active)
-                        SDL_RenderCopy(renderer, rockTexture, NULL, &rocks[i].rect);
+            // The playfield goes through the resolution scaler; the HUD is
+            // drawn on top at full resolution.
+            beginPerfPhase(PERF_RENDER);
+            int cameraY = view->cameraY;
+            beginScaledFrame(&scaler, renderer);
+            // Everything in the mine is drawn relative to the camera. The
+            // background scrolls away with the surface; below it, its
+            // bottom third repeats as deep rock.
+            SDL_Rect bgRect = {0, -cameraY, VIEW_WIDTH, VIEW_HEIGHT};
+            drawPlayfieldImage(&raster, renderer, bgTexture, &round.backgroundImage, NULL, &bgRect, 255);
+            SDL_Rect deepSrc = {0, bgH * 2 / 3, bgW, bgH / 3};
+            int tileH = VIEW_HEIGHT / 3;
+            int firstTile = cameraY > VIEW_HEIGHT ? (cameraY - VIEW_HEIGHT) / tileH : 0;
+            for (int y = VIEW_HEIGHT + firstTile * tileH - cameraY; y < VIEW_HEIGHT; y += tileH) {
+                SDL_Rect deepRect = {0, y, VIEW_WIDTH, tileH};
+                drawPlayfieldImage(&raster, renderer, bgTexture, &round.backgroundImage, &deepSrc, &deepRect, 255);
+            }
+            for (int i = 0; i < view->numObjects; i++) {
+                SDL_Rect r = view->objects[i].rect;
+                r.y -= cameraY;
+                drawPlayfieldImage(&raster, renderer, objectTexture(&assets, view->objects[i].kind),
+                                   objectImage(&assets, view->objects[i].kind), NULL, &r, 255);
+            }
+            for (int pi = 0; pi < view->numPlayers; pi++) {
+                const PlayerState* p = &view->players[pi];
+                // The other player's character and hook are tinted blue.
+                Uint8 tint = pi == localPlayer ? 255 : 150;
+                SDL_SetTextureColorMod(textures[TEX_CHARACTER], tint, tint, 255);
+                SDL_SetTextureColorMod(textures[TEX_HOOK], tint, tint, 255);
+                SDL_SetTextureColorMod(assets.hookSprites[HOOK_SPRITE_HOOK].texture, tint, tint, 255);
+                if (p->carrying) {
+                    SDL_Rect r = p->carriedRect;
+                    r.y -= cameraY;
+                    drawPlayfieldImage(&raster, renderer, objectTexture(&assets, p->carriedKind),
+                                       objectImage(&assets, p->carriedKind), NULL, &r, 255);
                 }
-                SDL_RenderCopy(renderer, charTexture, NULL, &charRect);
-                float angleDeg = -(currentAngle * 180.0f / PI);
-                if (hookState == dynamite_MOVING) {
-                    SDL_Rect dynamiteRect = { (int)hookX - hookW/2, (int)hookY - hookH/2, hookW, hookH };
-                    SDL_RenderCopyEx(renderer, dynamiteTexture, NULL, &dynamiteRect, angleDeg, &hookPivot, SDL_FLIP_NONE);
-                } else if (hookState == dynamite_EXPLOSION) {
+                SDL_Rect charScreen = p->charRect;
+                charScreen.y -= cameraY;
+                drawPlayfieldImage(&raster, renderer, textures[TEX_CHARACTER], &assets.images[TEX_CHARACTER], NULL, &charScreen, tint);
+                float angleDeg = -(p->currentAngle * 180.0f / PI);
+                SDL_Rect hookScreen = view->hookRects[pi];
+                hookScreen.y -= cameraY;
+                if (p->hookState == dynamite_MOVING) {
+                    if (!drawPlayfieldHook(&raster, renderer, &assets, HOOK_SPRITE_DYNAMITE, &hookScreen, view->hookPivot, angleDeg, 255))
+                        SDL_RenderCopyEx(renderer, textures[TEX_DYNAMITE], NULL, &hookScreen, angleDeg, &view->hookPivot, SDL_FLIP_NONE);
+                } else if (p->hookState == dynamite_EXPLOSION) {
                     SDL_Rect explosionRect;
-                    explosionRect.x = (int)explosionX - hookW/2;
-                    explosionRect.y = (int)explosionY - hookH/2;
+                    explosionRect.x = (int)p->explosionX - view->hookW/2;
+                    explosionRect.y = (int)p->explosionY - view->hookH/2 - cameraY;
                     explosionRect.w = 100;
                     explosionRect.h = 100;
-                    SDL_RenderCopy(renderer, implodeTexture, NULL, &explosionRect);
-                } else {
-                    SDL_RenderCopyEx(renderer, hookTexture, NULL, &hookRect, angleDeg, &hookPivot, SDL_FLIP_NONE);
-                }
-                int hookPivotScreenX = hookRect.x + hookPivot.x;
-                int hookPivotScreenY = hookRect.y + hookPivot.y;
-                SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-                SDL_RenderDrawLine(renderer, (int)anchorX, (int)anchorY, hookPivotScreenX, hookPivotScreenY);
-                char scoreText[32];
-                sprintf(scoreText, "Score: %d", score);
-                SDL_Color whiteColor = {255, 255, 255, 255};
-                SDL_Surface* textSurface = TTF_RenderText_Blended(font, scoreText, whiteColor);
-                if (textSurface) {
-                    SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-                    SDL_FreeSurface(textSurface);
-                    SDL_Rect textRect = {10, 10, 0, 0};
-                    SDL_QueryTexture(textTexture, NULL, NULL, &textRect.w, &textRect.h);
-                    SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
-                    SDL_DestroyTexture(textTexture);
-                }
-                for (int i = 0; i < availabledynamites; i++) {
-                    SDL_Rect dRect = { charRect.x + charRect.w + i * 50, 50, 50, 50 };
-                    SDL_RenderCopy(renderer, dynamiteTexture, NULL, &dRect);
+                    drawPlayfieldImage(&raster, renderer, textures[TEX_EXPLOSION], &assets.images[TEX_EXPLOSION], NULL, &explosionRect, 255);
+                } else if (!drawPlayfieldHook(&raster, renderer, &assets, HOOK_SPRITE_HOOK, &hookScreen, view->hookPivot, angleDeg, tint)) {
+                    SDL_RenderCopyEx(renderer, textures[TEX_HOOK], NULL, &hookScreen, angleDeg, &view->hookPivot, SDL_FLIP_NONE);
                 }
-                char timerText[32];
-                int minutes = ((int)gameTimer) / 60;
-                int seconds = ((int)gameTimer) % 60;
-                sprintf(timerText, "Time: %d:%02d", minutes, seconds);
-                SDL_Surface* timerSurface = TTF_RenderText_Blended(font, timerText, whiteColor);
-                if (timerSurface) {
-                    SDL_Texture* timerTexture = SDL_CreateTextureFromSurface(renderer, timerSurface);
-                    SDL_FreeSurface(timerSurface);
-                    SDL_Rect timerRect = {10, 40, 0, 0};
-                    SDL_QueryTexture(timerTexture, NULL, NULL, &timerRect.w, &timerRect.h);
-                    SDL_RenderCopy(renderer, timerTexture, NULL, &timerRect);
-                    SDL_DestroyTexture(timerTexture);
-                }
-            } else {
-                SDL_Rect fullScreen = {0, 0, 1366, 768};
-                SDL_RenderCopy(renderer, failureTexture, NULL, &fullScreen);
             }
+            SDL_SetTextureColorMod(textures[TEX_CHARACTER], 255, 255, 255);
+            SDL_SetTextureColorMod(textures[TEX_HOOK], 255, 255, 255);
+            SDL_SetTextureColorMod(assets.hookSprites[HOOK_SPRITE_HOOK].texture, 255, 255, 255);
+            if (raster.target) {
+                // SDL's clear has to land first, and the ropes and
+                // particles after.
+                SDL_RenderFlush(renderer);
+                flushRaster(&raster);
+            }
+            for (int pi = 0; pi < view->numPlayers; pi++)
+                drawRope(&view->ropes[pi], renderer, (float)cameraY, (SDL_Color){255, 0, 0, 255});
+            drawParticles(&particles, renderer, (float)cameraY);
+            endScaledFrame(&scaler, renderer);
+            char scoreText[32];
+            if (versus)
+                sprintf(scoreText, "Score: %d  Rival: %d", me->score, view->players[1 - localPlayer].score);
+            else
+                sprintf(scoreText, "Score: %d", me->score);
+            drawText(&hudText, renderer, scoreText, 10, 10);
+            for (int i = 0; i < me->dynamites; i++) {
+                SDL_Rect dRect = { me->charRect.x + me->charRect.w + i * 50, 50, 50, 50 };
+                SDL_RenderCopy(renderer, textures[TEX_DYNAMITE], NULL, &dRect);
+            }
+            char timerText[32];
+            int minutes = ((int)view->timeLeft) / 60;
+            int seconds = ((int)view->timeLeft) % 60;
+            sprintf(timerText, "Time: %d:%02d", minutes, seconds);
+            drawText(&hudText, renderer, timerText, 10, 40);
             SDL_RenderPresent(renderer);
-            SDL_Delay(16);
+            setMetricsPlay(round.levelIndex, me->hookState, me->score);
+            endMetricsFrame();
+            if (allocStats)
+                endFrameAllocs(&frameAllocs);
+            Uint64 frameTime = SDL_GetPerformanceCounter() - frameStart;
+            renderBusy += frameTime;
+            float frameMs = frameTime * 1000.0f / SDL_GetPerformanceFrequency();
+            recordFrameTime(&scaler, frameMs);
+            // Sleep out the rest of a 60 Hz frame; the simulation keeps
+            // its own time.
+            beginPerfPhase(PERF_IDLE);
+            if (frameMs < 16.0f)
+                SDL_Delay((Uint32)(16.0f - frameMs));
         } // End of game session loop
-        SDL_Rect fullScreenRect = {0, 0, 1366, 768};
-        if (score >= 400) {
-            SDL_RenderClear(renderer);
-            SDL_RenderCopy(renderer, successTexture, NULL, &fullScreenRect);
-            SDL_RenderPresent(renderer);
-            SDL_Delay(4000);
-            // Win: After showing success, return to main menu.
+        stopSimThread(&sim);
+        printf("Threads busy: simulation %.0f%%, render %.0f%%\n", simThreadBusy(&sim) * 100.0f,
+               renderBusy * 100.0f / (SDL_GetPerformanceCounter() - renderStart));
+        if (replayPrefix && game.timeUp) {
+            char replayPath[256];
+            snprintf(replayPath, sizeof(replayPath), "%s%ld.rep", replayPrefix, (long)time(NULL));
+            if (saveReplay(replayPath, &replay, &game))
+                printf("Replay saved to %s\n", replayPath);
+        }
+        bool online = sim.online; // Still hearing from the other player
+        const PlayerState* me = &game.players[localPlayer];
+        stopAllSfx();
+        countMetricsRound();
+        char perfTitle[48];
+        sprintf(perfTitle, "Perf counters, level %d", round.levelIndex);
+        printPerfPhases(perfTitle, false);
+        if (allocStats)
+            checkFrameAllocs(&frameAllocs);
+        int score = me->score;
+        bool won;
+        int nextLevel;
+        if (versus) {
+            // Make sure the other side can finish the round too.
+            if (online) {
+                flushNetRound(&net, game.tick);
+                printNetStats(&net);
+            } else {
+                closeNetSession(&net);
+                versus = false;
+            }
+            // Versus rounds go through the levels in order whoever wins, so
+            // both machines always load the same one.
+            won = score > game.players[1 - localPlayer].score;
+            nextLevel = round.levelIndex + 1;
         } else {
-            SDL_RenderClear(renderer);
-            SDL_RenderCopy(renderer, failureTexture, NULL, &fullScreenRect);
-            SDL_RenderPresent(renderer);
-            SDL_Delay(4000);
+            won = score >= tuning->target;
+            nextLevel = won ? round.levelIndex + 1 : round.levelIndex;
         }
+        // Load the next round (the following level on a win, the same one
+        // again on a loss) while the result is on screen.
+        startRoundPreload(&preload, nextLevel, raster.target != NULL, &roundArenas[nextArena++ & 1]);
+        setMetricsScreen(SCREEN_RESULT);
+        bool windowOpen = runScreen(renderer, resultScreen(renderer, won ? textures[TEX_SUCCESS] : textures[TEX_FAILURE], &preload));
         updateHighScores(score);
+        freeMine(&mine);
+        freeRoundData(&round);
+        printf("Round arena: %zu KB used, peak %zu KB of %zu KB\n", (round.arena->used + round.arena->overflowBytes) / 1024, round.arena->peak / 1024, round.arena->size / 1024);
+        resetArena(round.arena);
+        if (!windowOpen)
+            exitProgram = true;
 
     } // End of main session loop (returns to menu after each game session)
-    SDL_DestroyTexture(hookTexture);
-    SDL_DestroyTexture(rockTexture);
-    SDL_DestroyTexture(goldTexture);
-    SDL_DestroyTexture(charTexture);
-    SDL_DestroyTexture(bgTexture);
-    SDL_DestroyTexture(dynamiteTexture);
-    SDL_DestroyTexture(implodeTexture);
-    SDL_DestroyTexture(mysbagTexture);
-    SDL_DestroyTexture(successTexture);
-    SDL_DestroyTexture(failureTexture);
+    cancelRoundPreload(&preload);
+    for (int i = 0; i < 2; i++)
+        freeArena(&roundArenas[i]);
+    if (versus)
+        closeNetSession(&net);
+    freeParticles(&particles);
+    freeRenderScaler(&scaler);
+    freeTextAtlas(&hudText);
+    freeGameAssets(&assets);
     SDL_DestroyRenderer(renderer);
+    freeRaster(&raster);
     SDL_DestroyWindow(window);
-    TTF_CloseFont(font);
-    TTF_CloseFont(font48);
-    Mix_FreeMusic(targetMusic);
-    Mix_CloseAudio();
+    freeSdfFont(&font);
     IMG_Quit();
-    TTF_Quit();
+    stopTelemetry();
+    closeMetrics();
+    printPerfPhases("Perf counters, whole run", true);
+    closePerfCounters();
     SDL_Quit();
     return 0;
 }
 
-void showTargetScreen(SDL_Renderer* renderer, TTF_Font* font48, SDL_Texture* targetTexture, Mix_Music* targetMusic, int neededPoints) {
-    if (targetMusic)
-        Mix_PlayMusic(targetMusic, 1);
-    char targetText[64];
-    sprintf(targetText, "%d points", neededPoints);
-    SDL_Color white = {255,255,255,255};
-    SDL_Surface* textSurface = TTF_RenderText_Blended(font48, targetText, white);
-    if (!textSurface) {
-        printf("Error rendering target text: %s\n", TTF_GetError());
-        return;
-    }
-    SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    SDL_FreeSurface(textSurface);
-    int textW, textH;
-    SDL_QueryTexture(textTexture, NULL, NULL, &textW, &textH);
-    Uint32 startTime = SDL_GetTicks();
-    while (SDL_GetTicks() - startTime < 4000) {
+// Runs a screen sequence until it finishes, resuming it once per frame.
+// The event pump keeps running so the window never stops responding.
+// Returns false if the window was closed.
+bool runScreen(SDL_Renderer* renderer, Sequence screen) {
+    Uint32 lastTime = SDL_GetTicks();
+    bool running = true;
+    while (running) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT)
+                return false;
+        }
+        Uint32 currentTime = SDL_GetTicks();
         SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, targetTexture, NULL, NULL);
-        SDL_Rect textRect = { (1366 - textW)/2, (768 - textH)/2, textW, textH };
-        SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
+        running = screen.tick((currentTime - lastTime) / 1000.0f);
+        lastTime = currentTime;
         SDL_RenderPresent(renderer);
+        endMetricsFrame();
         SDL_Delay(16);
     }
-    SDL_DestroyTexture(textTexture);
+    return true;
+}
+
+Sequence targetScreen(SDL_Renderer* renderer, const TextAtlas* bigText, SDL_Texture* targetTexture, Mix_Music* targetMusic, RoundPreload* preload) {
+    if (targetMusic)
+        Mix_PlayMusic(targetMusic, 1);
+    float elapsed = 0.0f;
+    bool ready = false;
+    // Show the target for 4 seconds, longer only if the round is still loading.
+    while (elapsed < 4.0f || !ready) {
+        ready = pumpRoundPreload(preload, renderer);
+        SDL_RenderCopy(renderer, targetTexture, NULL, NULL);
+        if (roundLevelReady(preload)) {
+            char targetText[64];
+            sprintf(targetText, "%d points", preload->round.level.header->target);
+            drawText(bigText, renderer, targetText, (1366 - measureText(bigText, targetText)) / 2, (768 - bigText->height) / 2);
+        }
+        if (!ready) {
+            SDL_Rect barRect = { 0, 764, (int)(1366 * roundPreloadProgress(preload)), 4 };
+            SDL_SetRenderDrawColor(renderer, 255, 215, 0, 255);
+            SDL_RenderFillRect(renderer, &barRect);
+        }
+        elapsed += co_await nextFrame();
+    }
 }
 
-void showControls(SDL_Renderer* renderer, TTF_Font* font) {
+Sequence resultScreen(SDL_Renderer* renderer, SDL_Texture* resultTexture, RoundPreload* preload) {
+    SDL_Rect fullScreenRect = {0, 0, 1366, 768};
+    for (float elapsed = 0.0f; elapsed < 4.0f; elapsed += co_await nextFrame()) {
+        pumpRoundPreload(preload, renderer);
+        SDL_RenderCopy(renderer, resultTexture, NULL, &fullScreenRect);
+    }
+}
+
+void showControls(SDL_Renderer* renderer, const TextAtlas* text) {
     bool done = false;
     SDL_Event e;
     while (!done) {
@@ -528,40 +583,31 @@ void showControls(SDL_Renderer* renderer, TTF_Font* font) {
         }
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 200);
         SDL_RenderClear(renderer);
-        SDL_Color white = {255,255,255,255};
         const char* line1 = "Controls:";
         const char* line2 = "Up button = Dynamite";
         const char* line3 = "Down button = Lower Mining Crank";
         const char* line4 = "(Press ESC to go back)";
-        auto renderLine = [renderer, font, white](const char* text, int yOffset) {
-            SDL_Surface* surf = TTF_RenderText_Blended(font, text, white);
-            if (!surf) return;
-            SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surf);
-            SDL_FreeSurface(surf);
-            SDL_Rect rect = {0,0,0,0};
-            SDL_QueryTexture(tex, NULL, NULL, &rect.w, &rect.h);
-            rect.x = (1366 - rect.w)/2;
-            rect.y = yOffset;
-            SDL_RenderCopy(renderer, tex, NULL, &rect);
-            SDL_DestroyTexture(tex);
+        auto renderLine = [renderer, text](const char* line, int yOffset) {
+            drawText(text, renderer, line, (1366 - measureText(text, line)) / 2, yOffset);
         };
         renderLine(line1, 150);
         renderLine(line2, 200);
         renderLine(line3, 240);
         renderLine(line4, 300);
         SDL_RenderPresent(renderer);
+        endMetricsFrame();
         SDL_Delay(16);
     }
 }
 
-int runMenu(SDL_Renderer* renderer, TTF_Font* font) {
-    SDL_Surface* menuBGSurface = IMG_Load("daovang.png");
+int runMenu(SDL_Renderer* renderer, const TextAtlas* text, GameAssets* assets) {
+    SDL_Surface* menuBGSurface = trackedLoadImage("daovang.png");
     if (!menuBGSurface) {
         printf("Error loading daovang.png: %s\n", IMG_GetError());
         return 1;
     }
-    SDL_Texture* menuBGTexture = SDL_CreateTextureFromSurface(renderer, menuBGSurface);
-    SDL_FreeSurface(menuBGSurface);
+    SDL_Texture* menuBGTexture = trackedCreateTextureFromSurface(renderer, menuBGSurface);
+    trackedFreeSurface(menuBGSurface);
     SDL_Rect goldRect = {420,150,200,200};
     SDL_Rect controlRect = {300,500,200,50};
     SDL_Rect scoresRect = {500,500,200,50};
@@ -570,19 +616,19 @@ int runMenu(SDL_Renderer* renderer, TTF_Font* font) {
     while (running) {
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) {
-                SDL_DestroyTexture(menuBGTexture);
+                trackedDestroyTexture(menuBGTexture);
                 return 1;
             } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
                 int mx = e.button.x;
                 int my = e.button.y;
                 if (mx >= goldRect.x && mx <= goldRect.x + goldRect.w && my >= goldRect.y && my <= goldRect.y + goldRect.h) {
-                    SDL_DestroyTexture(menuBGTexture);
+                    trackedDestroyTexture(menuBGTexture);
                     return 0;
                 }
                 if (mx >= controlRect.x && mx <= controlRect.x + controlRect.w && my >= controlRect.y && my <= controlRect.y + controlRect.h)
-                    showControls(renderer, font);
+                    showControls(renderer, text);
                 if (mx >= scoresRect.x && mx <= scoresRect.x + scoresRect.w && my >= scoresRect.y && my <= scoresRect.y + scoresRect.h)
-                    showHighScores(renderer, font);
+                    showHighScores(renderer, text);
             }
         }
         SDL_RenderClear(renderer);
@@ -591,43 +637,25 @@ int runMenu(SDL_Renderer* renderer, TTF_Font* font) {
         SDL_RenderFillRect(renderer, &controlRect);
         SDL_SetRenderDrawColor(renderer, 0,0,255,100);
         SDL_RenderFillRect(renderer, &scoresRect);
-        SDL_Color white = {255,255,255,255};
-        SDL_Surface* bgnSurf = TTF_RenderText_Blended(font, "Begin", white);
-        if (bgnSurf) {
-            SDL_Texture* bgnText = SDL_CreateTextureFromSurface(renderer, bgnSurf);
-            SDL_FreeSurface(bgnSurf);
-            SDL_Rect bgnTextRect = {goldRect.x, goldRect.y, 0, 0};
-            SDL_QueryTexture(bgnText, NULL, NULL, &bgnTextRect.w, &bgnTextRect.h);
-            bgnTextRect.x += (goldRect.w - bgnTextRect.w) / 2;
-            bgnTextRect.y += (goldRect.h - bgnTextRect.h) / 2;
-            SDL_RenderCopy(renderer, bgnText, NULL, &bgnTextRect);
-            SDL_DestroyTexture(bgnText);
-        }
-        SDL_Surface* ctrlSurf = TTF_RenderText_Blended(font, "Control", white);
-        if (ctrlSurf) {
-            SDL_Texture* ctrlText = SDL_CreateTextureFromSurface(renderer, ctrlSurf);
-            SDL_FreeSurface(ctrlSurf);
-            SDL_Rect ctrlTextRect = {controlRect.x, controlRect.y, 0, 0};
-            SDL_QueryTexture(ctrlText, NULL, NULL, &ctrlTextRect.w, &ctrlTextRect.h);
-            ctrlTextRect.x += (controlRect.w - ctrlTextRect.w) / 2;
-            ctrlTextRect.y += (controlRect.h - ctrlTextRect.h) / 2;
-            SDL_RenderCopy(renderer, ctrlText, NULL, &ctrlTextRect);
-            SDL_DestroyTexture(ctrlText);
-        }
-        SDL_Surface* scoresSurf = TTF_RenderText_Blended(font, "High Scores", white);
-        if (scoresSurf) {
-            SDL_Texture* scoresText = SDL_CreateTextureFromSurface(renderer, scoresSurf);
-            SDL_FreeSurface(scoresSurf);
-            SDL_Rect scoresTextRect = {scoresRect.x, scoresRect.y, 0, 0};
-            SDL_QueryTexture(scoresText, NULL, NULL, &scoresTextRect.w, &scoresTextRect.h);
-            scoresTextRect.x += (scoresRect.w - scoresTextRect.w) / 2;
-            scoresTextRect.y += (scoresRect.h - scoresTextRect.h) / 2;
-            SDL_RenderCopy(renderer, scoresText, NULL, &scoresTextRect);
-            SDL_DestroyTexture(scoresText);
-        }
+        // Labels are centred in their buttons.
+        auto renderLabel = [renderer, text](const char* label, const SDL_Rect& button) {
+            drawText(text, renderer, label, button.x + (button.w - measureText(text, label)) / 2,
+                     button.y + (button.h - text->height) / 2);
+        };
+        renderLabel("Begin", goldRect);
+        renderLabel("Control", controlRect);
+        renderLabel("High Scores", scoresRect);
         SDL_RenderPresent(renderer);
+        endMetricsFrame();
+        if (launchTime != 0) {
+            float ms = (SDL_GetPerformanceCounter() - launchTime) * 1000.0f / SDL_GetPerformanceFrequency();
+            printf("First menu frame %.0f ms after launch\n", ms);
+            setMetricsStartupLoad(ms);
+            launchTime = 0;
+        }
+        pumpGameAssets(assets, renderer);
         SDL_Delay(16);
     }
-    SDL_DestroyTexture(menuBGTexture);
+    trackedDestroyTexture(menuBGTexture);
     return 1;
 }
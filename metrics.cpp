@@ -0,0 +1,194 @@
+#include "metrics.h"
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static MetricsShared* shared;
+#ifdef _WIN32
+static HANDLE mapping;
+#endif
+static MetricsBlock local;   // What the game writes to between publishes.
+static Uint64 lastFrame;
+static Uint32 fpsStart;
+static int fpsFrames;
+
+static const char* SCREEN_NAMES[NUM_SCREENS] = {"menu", "target", "session", "result"};
+
+const char* metricsScreenName(int screen) {
+    return screen >= 0 && screen < NUM_SCREENS ? SCREEN_NAMES[screen] : "unknown";
+}
+
+static void* createBlock(size_t size) {
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, METRICS_NAME);
+    if (mapping == NULL)
+        return NULL;
+    void* mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (mem == NULL) {
+        CloseHandle(mapping);
+        mapping = NULL;
+    }
+    return mem;
+#else
+    int fd = shm_open(METRICS_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return NULL;
+    void* mem = ftruncate(fd, (off_t)size) == 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(METRICS_NAME);
+        return NULL;
+    }
+    return mem;
+#endif
+}
+
+bool openMetrics(void) {
+    if (shared != NULL)
+        return true;
+    void* mem = createBlock(sizeof(MetricsShared));
+    if (mem == NULL) {
+        printf("Live metrics are off: no shared memory block %s\n", METRICS_NAME);
+        return false;
+    }
+    shared = new (mem) MetricsShared;
+    shared->sequence.store(0, std::memory_order_relaxed);
+    memset(&shared->block, 0, sizeof(shared->block));
+    memset(&local, 0, sizeof(local));
+#ifdef _WIN32
+    local.pid = (Uint32)GetCurrentProcessId();
+#else
+    local.pid = (Uint32)getpid();
+#endif
+    local.level = -1;
+    shared->magic = METRICS_MAGIC;
+    shared->version = METRICS_VERSION;
+    shared->blockSize = (Uint16)sizeof(MetricsBlock);
+    lastFrame = 0;
+    fpsStart = SDL_GetTicks();
+    fpsFrames = 0;
+    return true;
+}
+
+void closeMetrics(void) {
+    if (shared == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(shared);
+    CloseHandle(mapping);
+    mapping = NULL;
+#else
+    munmap(shared, sizeof(MetricsShared));
+    shm_unlink(METRICS_NAME);
+#endif
+    shared = NULL;
+}
+
+void setMetricsScreen(MetricsScreen screen) {
+    local.screen = screen;
+}
+
+void setMetricsPlay(int level, int hookState, int score) {
+    local.level = level;
+    local.hookState = (Uint32)hookState;
+    local.score = score;
+}
+
+void countMetricsRound(void) {
+    local.roundsPlayed++;
+}
+
+void setMetricsStartupLoad(float ms) {
+    local.startupLoadMs = ms;
+}
+
+void setMetricsRoundLoad(float ms) {
+    local.roundLoadMs = ms;
+    if (ms > local.roundLoadMaxMs)
+        local.roundLoadMaxMs = ms;
+}
+
+void endMetricsFrame(void) {
+    if (shared == NULL)
+        return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (lastFrame != 0) {
+        local.frameMs = (float)(now - lastFrame) * 1000.0f / SDL_GetPerformanceFrequency();
+        int bucket = (int)local.frameMs / METRICS_BUCKET_MS;
+        local.frameHistogram[bucket < METRICS_FRAME_BUCKETS ? bucket : METRICS_FRAME_BUCKETS - 1]++;
+    }
+    lastFrame = now;
+    Uint32 ticks = SDL_GetTicks();
+    fpsFrames++;
+    if (ticks - fpsStart >= 1000) {
+        local.fps = fpsFrames * 1000.0f / (ticks - fpsStart);
+        fpsStart = ticks;
+        fpsFrames = 0;
+    }
+    local.updatedMs = ticks;
+    // Odd while the copy is in progress; readers that see the number change
+    // throw their copy away.
+    Uint32 sequence = shared->sequence.load(std::memory_order_relaxed);
+    shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&shared->block, &local, sizeof(local));
+    shared->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+const MetricsShared* mapMetrics(void) {
+    void* mem;
+#ifdef _WIN32
+    HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, METRICS_NAME);
+    if (handle == NULL)
+        return NULL;
+    mem = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, sizeof(MetricsShared));
+    CloseHandle(handle);  // The view keeps the mapping alive.
+    if (mem == NULL)
+        return NULL;
+#else
+    int fd = shm_open(METRICS_NAME, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    mem = fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(MetricsShared)
+              ? mmap(NULL, sizeof(MetricsShared), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mem == MAP_FAILED)
+        return NULL;
+#endif
+    const MetricsShared* block = (const MetricsShared*)mem;
+    if (block->magic != METRICS_MAGIC || block->version != METRICS_VERSION || block->blockSize != sizeof(MetricsBlock)) {
+        unmapMetrics(block);
+        return NULL;
+    }
+    return block;
+}
+
+void unmapMetrics(const MetricsShared* block) {
+#ifdef _WIN32
+    UnmapViewOfFile(block);
+#else
+    munmap((void*)block, sizeof(MetricsShared));
+#endif
+}
+
+bool readMetrics(const MetricsShared* block, MetricsBlock* out) {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        Uint32 before = block->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+        memcpy(out, &block->block, sizeof(*out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block->sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <atomic>
+
+// Live metrics for an external monitor (tools/metricsmon.cpp). The game
+// keeps them in a private copy and, once per frame, copies that into a
+// fixed-layout block in shared memory under a sequence lock. The game never
+// waits on a reader, and a reader never talks to the game: it copies the
+// block and retries if the sequence moved while it did.
+
+#define METRICS_MAGIC 0x544D4744u     // "DGMT"
+#define METRICS_VERSION 1
+#ifdef _WIN32
+#define METRICS_NAME "Local\\daovang-metrics"
+#else
+#define METRICS_NAME "/daovang-metrics"
+#endif
+
+// Frame time histogram: 2 ms buckets, the last one open-ended.
+#define METRICS_FRAME_BUCKETS 16
+#define METRICS_BUCKET_MS 2
+
+typedef enum { SCREEN_MENU, SCREEN_TARGET, SCREEN_SESSION, SCREEN_RESULT, NUM_SCREENS } MetricsScreen;
+
+typedef struct {
+    Uint32 pid;
+    Uint32 updatedMs;         // SDL_GetTicks() of the last publish.
+    Uint32 screen;            // MetricsScreen
+    float fps;                // Frames in the last whole second.
+    float frameMs;            // Last frame, present to present.
+    Uint32 frameHistogram[METRICS_FRAME_BUCKETS];  // Frames since start.
+    Uint32 roundsPlayed;
+    Sint32 level;
+    Uint32 hookState;         // HookState of the local player.
+    Sint32 score;
+    float startupLoadMs;      // Start of main() to the first menu frame.
+    float roundLoadMs;        // Last round: preload start to everything ready.
+    float roundLoadMaxMs;
+} MetricsBlock;
+
+typedef struct {
+    Uint32 magic;
+    Uint16 version;
+    Uint16 blockSize;
+    std::atomic<Uint32> sequence;  // Odd while the game is writing.
+    MetricsBlock block;
+} MetricsShared;
+
+// Creates the shared block. The game runs on without it if this fails.
+bool openMetrics(void);
+void closeMetrics(void);
+
+void setMetricsScreen(MetricsScreen screen);
+void setMetricsPlay(int level, int hookState, int score);
+void countMetricsRound(void);
+void setMetricsStartupLoad(float ms);
+void setMetricsRoundLoad(float ms);
+
+// Call once per frame, after presenting: times the frame and publishes.
+void endMetricsFrame(void);
+
+// Reader side. Maps an existing block read-only; NULL if there is none.
+const MetricsShared* mapMetrics(void);
+void unmapMetrics(const MetricsShared* shared);
+
+// Copies a consistent block out. False if the game kept writing for the
+// whole attempt.
+bool readMetrics(const MetricsShared* shared, MetricsBlock* out);
+
+const char* metricsScreenName(int screen);
+
+#endif // METRICS_H
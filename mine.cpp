@@ -0,0 +1,187 @@
+#include "mine.h"
+#include <stdlib.h>
+#include <string.h>
+#include "level_gen.h"
+
+static int chunkOf(const Mine* mine, int y) {
+    int c = y > 0 ? y / CHUNK_HEIGHT : 0;
+    return c < mine->numChunks ? c : mine->numChunks - 1;
+}
+
+// Chunks below the first screen of a seeded mine are generated rather than
+// taken from the level.
+static bool chunkIsGenerated(const Mine* mine, int c) {
+    return mine->level->header->mineSeed != 0 && c * CHUNK_HEIGHT >= VIEW_HEIGHT;
+}
+
+// Stable counting sort of objects by chunk. start[c] ends up as the first
+// object of chunk c, and start[numChunks] as the object count.
+template <typename T>
+static void sortByChunk(const Mine* mine, T* items, int count, int* start, int* next, T* temp) {
+    memset(start, 0, sizeof(int) * (mine->numChunks + 1));
+    for (int i = 0; i < count; i++)
+        start[chunkOf(mine, items[i].rect.y) + 1]++;
+    for (int c = 0; c < mine->numChunks; c++)
+        start[c + 1] += start[c];
+    memcpy(next, start, sizeof(int) * mine->numChunks);
+    for (int i = 0; i < count; i++)
+        temp[next[chunkOf(mine, items[i].rect.y)]++] = items[i];
+    memcpy(items, temp, sizeof(T) * count);
+}
+
+bool initMine(Mine* mine, Level* level, Arena* arena) {
+    const LevelHeader* h = level->header;
+    mine->level = level;
+    mine->arena = arena;
+    mine->depth = h->depth;
+    mine->numChunks = (h->depth + CHUNK_HEIGHT - 1) / CHUNK_HEIGHT;
+    for (int i = 0; i < MINE_RESIDENT_CHUNKS; i++)
+        mine->chunks[i].index = -1;
+    // goldStart, rockStart and the sort's cursors share one allocation.
+    mine->goldStart = (int*)arenaAlloc(arena, sizeof(int) * 3 * (mine->numChunks + 1));
+    if (mine->goldStart == NULL)
+        return false;
+    mine->rockStart = mine->goldStart + mine->numChunks + 1;
+    size_t tempSize = sizeof(GoldObject) * h->numGolds;
+    if (sizeof(RockObject) * h->numRocks > tempSize)
+        tempSize = sizeof(RockObject) * h->numRocks;
+    void* temp = arenaAlloc(arena, tempSize > 0 ? tempSize : 1);
+    if (temp == NULL) {
+        arenaFree(arena, mine->goldStart);
+        mine->goldStart = NULL;
+        return false;
+    }
+    mine->genScratch = NULL;
+    if (h->mineSeed != 0) {
+        LevelGenParams chunkField = {};
+        chunkField.width = VIEW_WIDTH;
+        chunkField.height = CHUNK_HEIGHT;
+        mine->genScratch = arenaAlloc(arena, levelGenScratchSize(&chunkField));
+        if (mine->genScratch == NULL) {
+            arenaFree(arena, temp);
+            arenaFree(arena, mine->goldStart);
+            mine->goldStart = NULL;
+            return false;
+        }
+    }
+    int* cursors = mine->rockStart + mine->numChunks + 1;
+    sortByChunk(mine, level->golds, h->numGolds, mine->goldStart, cursors, (GoldObject*)temp);
+    sortByChunk(mine, level->rocks, h->numRocks, mine->rockStart, cursors, (RockObject*)temp);
+    arenaFree(arena, temp);
+    return true;
+}
+
+// Marks everything in a resident chunk present except what has been taken.
+static void applyTaken(MineChunk* chunk, const MineTaken* taken, int numTaken) {
+    for (int i = 0; i < chunk->numGolds; i++)
+        chunk->golds[i].active = true;
+    for (int i = 0; i < chunk->numRocks; i++)
+        chunk->rocks[i].active = true;
+    for (int i = 0; i < numTaken; i++) {
+        const MineTaken* t = &taken[i];
+        if (t->chunk != chunk->index)
+            continue;
+        if (t->isRock)
+            chunk->rocks[t->index].active = false;
+        else
+            chunk->golds[t->index].active = false;
+    }
+}
+
+static void loadChunk(Mine* mine, MineChunk* chunk, int c, const MineTaken* taken, int numTaken) {
+    chunk->index = c;
+    if (!chunkIsGenerated(mine, c)) {
+        chunk->golds = mine->level->golds + mine->goldStart[c];
+        chunk->numGolds = mine->goldStart[c + 1] - mine->goldStart[c];
+        chunk->rocks = mine->level->rocks + mine->rockStart[c];
+        chunk->numRocks = mine->rockStart[c + 1] - mine->rockStart[c];
+        applyTaken(chunk, taken, numTaken);
+        return;
+    }
+    LevelGenParams params;
+    params.seed = (mine->level->header->mineSeed ^ ((Uint32)c * 2654435761u)) | 1u;
+    params.width = VIEW_WIDTH;
+    params.top = c * CHUNK_HEIGHT;
+    params.height = mine->depth - params.top < CHUNK_HEIGHT ? mine->depth - params.top : CHUNK_HEIGHT;
+    params.maxObjects = MINE_CHUNK_OBJECTS;
+    // Bands run over the whole generated part, so the mine gets richer with depth.
+    params.bandTop = VIEW_HEIGHT;
+    params.bandHeight = mine->depth - VIEW_HEIGHT;
+    chunk->golds = chunk->goldStore;
+    chunk->rocks = chunk->rockStore;
+    generateObjects(&params, chunk->goldStore, CHUNK_MAX_GOLDS, &chunk->numGolds,
+                    chunk->rockStore, CHUNK_MAX_ROCKS, &chunk->numRocks, mine->genScratch);
+    applyTaken(chunk, taken, numTaken);
+}
+
+void streamMine(Mine* mine, const int* viewTops, int numViews, const MineTaken* taken, int numTaken) {
+    int first[MINE_MAX_VIEWS], last[MINE_MAX_VIEWS];
+    if (numViews > MINE_MAX_VIEWS)
+        numViews = MINE_MAX_VIEWS;
+    for (int v = 0; v < numViews; v++) {
+        first[v] = (viewTops[v] - MINE_OBJECT_REACH) / CHUNK_HEIGHT - 1;
+        last[v] = (viewTops[v] + VIEW_HEIGHT) / CHUNK_HEIGHT + 1;
+        if (first[v] < 0) first[v] = 0;
+        if (last[v] > mine->numChunks - 1) last[v] = mine->numChunks - 1;
+    }
+    for (int i = 0; i < MINE_RESIDENT_CHUNKS; i++) {
+        int c = mine->chunks[i].index;
+        bool wanted = false;
+        for (int v = 0; v < numViews; v++)
+            wanted |= c >= first[v] && c <= last[v];
+        if (c != -1 && !wanted)
+            mine->chunks[i].index = -1;
+    }
+    for (int v = 0; v < numViews; v++) {
+        for (int c = first[v]; c <= last[v]; c++) {
+            int freeSlot = -1;
+            bool resident = false;
+            for (int i = 0; i < MINE_RESIDENT_CHUNKS && !resident; i++) {
+                resident = mine->chunks[i].index == c;
+                if (mine->chunks[i].index == -1 && freeSlot == -1)
+                    freeSlot = i;
+            }
+            if (!resident && freeSlot != -1)
+                loadChunk(mine, &mine->chunks[freeSlot], c, taken, numTaken);
+        }
+    }
+}
+
+int findMineChunks(Mine* mine, int top, int bottom, MineChunk** out) {
+    int n = 0;
+    for (int i = 0; i < MINE_RESIDENT_CHUNKS; i++) {
+        int c = mine->chunks[i].index;
+        if (c != -1 && c * CHUNK_HEIGHT < bottom && (c + 1) * CHUNK_HEIGHT + MINE_OBJECT_REACH > top)
+            out[n++] = &mine->chunks[i];
+    }
+    return n;
+}
+
+void refreshMine(Mine* mine, const MineTaken* taken, int numTaken) {
+    for (int i = 0; i < MINE_RESIDENT_CHUNKS; i++) {
+        if (mine->chunks[i].index != -1)
+            applyTaken(&mine->chunks[i], taken, numTaken);
+    }
+}
+
+bool takeMineObject(MineChunk* chunk, bool isRock, int index, MineTaken* taken, int* numTaken) {
+    if (isRock)
+        chunk->rocks[index].active = false;
+    else
+        chunk->golds[index].active = false;
+    if (*numTaken == MINE_MAX_TAKEN)
+        return false;
+    MineTaken* t = &taken[(*numTaken)++];
+    t->chunk = chunk->index;
+    t->index = (short)index;
+    t->isRock = isRock;
+    return true;
+}
+
+void freeMine(Mine* mine) {
+    arenaFree(mine->arena, mine->goldStart);
+    arenaFree(mine->arena, mine->genScratch);
+    mine->goldStart = NULL;
+    mine->rockStart = NULL;
+    mine->genScratch = NULL;
+}
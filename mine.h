@@ -0,0 +1,94 @@
+#ifndef MINE_H
+#define MINE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "level.h"
+#include "objects.h"
+
+// The visible part of the mine; the camera scrolls it vertically.
+#define VIEW_WIDTH 1366
+#define VIEW_HEIGHT 768
+
+// The mine is cut into horizontal chunks of this height. An object belongs
+// to the chunk its top edge is in and may hang up to MINE_OBJECT_REACH
+// pixels into the next one.
+#define CHUNK_HEIGHT 384
+#define MINE_OBJECT_REACH 64
+
+// A view can reach into this many chunks: the ones it overlaps and the one
+// above, whose objects hang into it. Everything in them is handed to the
+// renderer, so the loader refuses a level with more than
+// MINE_VIEW_MAX_OBJECTS objects in any run of MINE_VIEW_CHUNKS chunks. A
+// level packed full by levelgen has under 300.
+#define MINE_VIEW_CHUNKS (VIEW_HEIGHT / CHUNK_HEIGHT + 2)
+#define MINE_VIEW_MAX_OBJECTS 512
+
+// Chunks kept in memory: everything a view touches plus one chunk of
+// prefetch above and below. Six always cover a VIEW_HEIGHT view, and there
+// is a view per hook.
+#define MINE_MAX_VIEWS 2
+#define MINE_RESIDENT_CHUNKS (6 * MINE_MAX_VIEWS)
+
+// Room in a generated chunk, and how many objects it gets.
+#define CHUNK_MAX_GOLDS 16
+#define CHUNK_MAX_ROCKS 16
+#define MINE_CHUNK_OBJECTS 9
+
+// Objects taken this round. The list belongs to the game state, not the
+// mine: a chunk that streams in is loaded fresh and then has the taken
+// objects removed, so restoring an older list brings objects back.
+#define MINE_MAX_TAKEN 256
+
+typedef struct {
+    int index;                // Chunk number from the top, -1 for a free slot.
+    GoldObject* golds;        // Into the level for authored chunks, into the
+    RockObject* rocks;        // stores below for generated ones.
+    int numGolds;
+    int numRocks;
+    GoldObject goldStore[CHUNK_MAX_GOLDS];
+    RockObject rockStore[CHUNK_MAX_ROCKS];
+} MineChunk;
+
+typedef struct {
+    int chunk;
+    short index;
+    bool isRock;
+} MineTaken;
+
+typedef struct {
+    Level* level;
+    int depth;
+    int numChunks;
+    int* goldStart;           // First level gold of each chunk, numChunks + 1 entries.
+    int* rockStart;
+    MineChunk chunks[MINE_RESIDENT_CHUNKS];
+    void* genScratch;         // Generator working memory, so streaming never allocates.
+    Arena* arena;             // Where the above live; NULL for the heap.
+} Mine;
+
+// Sets up streaming over a loaded level. The level's objects are reordered
+// by chunk; the level must outlive the mine. The mine's tables go in
+// `arena` (NULL for the heap).
+bool initMine(Mine* mine, Level* level, Arena* arena);
+
+// Makes every chunk near the given views resident and drops the rest. Each
+// view is VIEW_HEIGHT tall and starts at viewTops[i].
+void streamMine(Mine* mine, const int* viewTops, int numViews, const MineTaken* taken, int numTaken);
+
+// Re-applies a taken list to the resident chunks, after it was swapped for
+// an older one.
+void refreshMine(Mine* mine, const MineTaken* taken, int numTaken);
+
+// Collects the resident chunks whose objects can reach into [top, bottom).
+// `out` needs room for MINE_RESIDENT_CHUNKS entries. Returns the count.
+int findMineChunks(Mine* mine, int top, int bottom, MineChunk** out);
+
+// Takes an object out of the mine and records it in the taken list.
+// Returns false if the list is full: the object is gone from the chunk for
+// now, but comes back if the chunk is loaded again.
+bool takeMineObject(MineChunk* chunk, bool isRock, int index, MineTaken* taken, int* numTaken);
+
+void freeMine(Mine* mine);
+
+#endif // MINE_H
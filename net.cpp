@@ -0,0 +1,516 @@
+#include "net.h"
+#include <stdio.h>
+#include <string.h>
+#include "game.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closeSocket close
+#endif
+
+#define NET_MAGIC 0x53564744u // "DGVS"
+#define PACKET_MAX 512
+#define RESEND_MS 50
+
+enum {
+    PACKET_HELLO = 1,         // magic                      client -> host
+    PACKET_WELCOME,           // magic                      host -> client
+    PACKET_PING,              // seq, sent (us)             host -> client
+    PACKET_PONG,              // seq, sent (us)             client -> host
+    PACKET_CONFIG,            // delay, rtt (us)            host -> client
+    PACKET_CONFIG_ACK,        //                            client -> host
+    PACKET_READY,             // round                      client -> host
+    PACKET_GO,                // round, seed, start offset  host -> client
+    PACKET_INPUT,             // round, confirmed, ack, n, n x (tick, offset, kind)
+    PACKET_BYE
+};
+
+// Little-endian packet writer and bounds-checked reader.
+typedef struct {
+    Uint8 data[PACKET_MAX];
+    int size;
+} PacketOut;
+
+typedef struct {
+    const Uint8* p;
+    const Uint8* end;
+    bool ok;
+} PacketIn;
+
+static void put8(PacketOut* out, Uint8 v) {
+    if (out->size < PACKET_MAX)
+        out->data[out->size++] = v;
+}
+
+static void put16(PacketOut* out, Uint16 v) {
+    put8(out, (Uint8)v);
+    put8(out, (Uint8)(v >> 8));
+}
+
+static void put32(PacketOut* out, Uint32 v) {
+    put16(out, (Uint16)v);
+    put16(out, (Uint16)(v >> 16));
+}
+
+static Uint8 get8(PacketIn* in) {
+    if (in->p >= in->end) {
+        in->ok = false;
+        return 0;
+    }
+    return *in->p++;
+}
+
+static Uint16 get16(PacketIn* in) {
+    Uint16 lo = get8(in);
+    return (Uint16)(lo | get8(in) << 8);
+}
+
+static Uint32 get32(PacketIn* in) {
+    Uint32 lo = get16(in);
+    return lo | (Uint32)get16(in) << 16;
+}
+
+static Uint32 microsNow(void) {
+    return (Uint32)((double)SDL_GetPerformanceCounter() * 1e6 / (double)SDL_GetPerformanceFrequency());
+}
+
+static bool openSocket(NetSession* net, int port) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        printf("Winsock could not start\n");
+        return false;
+    }
+#endif
+    memset(net, 0, sizeof(NetSession));
+    net->socket = (intptr_t)socket(AF_INET, SOCK_DGRAM, 0);
+    if (net->socket == -1) {
+        printf("Error creating socket\n");
+        return false;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((Uint16)port);
+    if (bind(net->socket, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("Error binding UDP port %d\n", port);
+        closeSocket(net->socket);
+        return false;
+    }
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(net->socket, FIONBIO, &nonBlocking);
+#else
+    fcntl(net->socket, F_SETFL, fcntl(net->socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    net->lastHeard = SDL_GetTicks();
+    net->statsStart = SDL_GetTicks();
+    return true;
+}
+
+static void sendPacket(NetSession* net, const PacketOut* out) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = net->peerAddr;
+    addr.sin_port = net->peerPort;
+    if (sendto(net->socket, (const char*)out->data, out->size, 0, (struct sockaddr*)&addr, sizeof(addr)) == out->size) {
+        net->bytesSent += out->size;
+        net->packetsSent++;
+    }
+}
+
+static void sendSimple(NetSession* net, Uint8 type) {
+    PacketOut out = {{0}, 0};
+    put8(&out, type);
+    put32(&out, NET_MAGIC);
+    sendPacket(net, &out);
+}
+
+// Reads one datagram. Before the peer is known (host waiting for HELLO)
+// any sender is accepted and becomes the peer; after that, strangers are
+// ignored. Returns the packet type, or 0 if nothing arrived.
+static int receivePacket(NetSession* net, Uint8* buffer, PacketIn* in, bool acceptAny) {
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        int size = recvfrom(net->socket, (char*)buffer, PACKET_MAX, 0, (struct sockaddr*)&from, &fromLen);
+        if (size <= 0)
+            return 0;
+        if (acceptAny) {
+            net->peerAddr = from.sin_addr.s_addr;
+            net->peerPort = from.sin_port;
+        } else if (from.sin_addr.s_addr != net->peerAddr || from.sin_port != net->peerPort) {
+            continue;
+        }
+        net->bytesReceived += size;
+        net->packetsReceived++;
+        net->lastHeard = SDL_GetTicks();
+        in->p = buffer + 1;
+        in->end = buffer + size;
+        in->ok = true;
+        return buffer[0];
+    }
+}
+
+static void sendGo(NetSession* net) {
+    PacketOut out = {{0}, 0};
+    put8(&out, PACKET_GO);
+    put16(&out, net->round);
+    put32(&out, net->roundSeed);
+    put32(&out, (Uint32)(Sint32)(net->startTicks - SDL_GetTicks()));
+    sendPacket(net, &out);
+}
+
+// Answers the packets either side may receive at any time. Returns false
+// if the other side said goodbye.
+static bool handleControl(NetSession* net, int type, PacketIn* in) {
+    if (type == PACKET_PING && !net->isHost) {
+        Uint32 seq = get32(in), sent = get32(in);
+        PacketOut out = {{0}, 0};
+        put8(&out, PACKET_PONG);
+        put32(&out, seq);
+        put32(&out, sent);
+        sendPacket(net, &out);
+    } else if (type == PACKET_CONFIG && !net->isHost) {
+        net->inputDelay = get8(in);
+        net->rttMs = get32(in) / 1000.0f;
+        sendSimple(net, PACKET_CONFIG_ACK);
+    } else if (type == PACKET_HELLO && net->isHost) {
+        sendSimple(net, PACKET_WELCOME);
+    } else if (type == PACKET_READY && net->isHost && get16(in) == net->round && net->roundSeed != 0) {
+        sendGo(net); // The client missed the GO; the start time has moved closer since.
+    } else if (type == PACKET_BYE) {
+        return false;
+    }
+    return true;
+}
+
+bool hostNetSession(NetSession* net, int port) {
+    if (!openSocket(net, port))
+        return false;
+    net->isHost = true;
+    net->localPlayer = 0;
+    printf("Waiting for a player on UDP port %d...\n", port);
+    Uint8 buffer[PACKET_MAX];
+    PacketIn in;
+    bool joined = false;
+    for (Uint32 start = SDL_GetTicks(); !joined && SDL_GetTicks() - start < 60000; SDL_Delay(1)) {
+        SDL_PumpEvents();
+        int type = receivePacket(net, buffer, &in, true);
+        joined = type == PACKET_HELLO && get32(&in) == NET_MAGIC;
+    }
+    if (!joined) {
+        printf("Nobody joined\n");
+        closeNetSession(net);
+        return false;
+    }
+    sendSimple(net, PACKET_WELCOME);
+
+    // Measure the round trip; the median shrugs off one slow packet.
+    Uint32 rtts[NET_PINGS];
+    int numRtts = 0;
+    Uint32 seq = 0, lastPing = 0;
+    for (Uint32 start = SDL_GetTicks(); numRtts < NET_PINGS && SDL_GetTicks() - start < 3000; SDL_Delay(1)) {
+        if (SDL_GetTicks() - lastPing >= 20) {
+            PacketOut out = {{0}, 0};
+            put8(&out, PACKET_PING);
+            put32(&out, seq++);
+            put32(&out, microsNow());
+            sendPacket(net, &out);
+            lastPing = SDL_GetTicks();
+        }
+        int type;
+        while ((type = receivePacket(net, buffer, &in, false)) != 0) {
+            if (type == PACKET_PONG) {
+                get32(&in);
+                Uint32 sent = get32(&in);
+                if (in.ok && numRtts < NET_PINGS)
+                    rtts[numRtts++] = microsNow() - sent;
+            } else {
+                handleControl(net, type, &in);
+            }
+        }
+    }
+    if (numRtts == 0) {
+        printf("The other player does not answer\n");
+        closeNetSession(net);
+        return false;
+    }
+    for (int i = 1; i < numRtts; i++) {
+        Uint32 v = rtts[i];
+        int j = i;
+        for (; j > 0 && rtts[j - 1] > v; j--)
+            rtts[j] = rtts[j - 1];
+        rtts[j] = v;
+    }
+    Uint32 rttMicros = rtts[numRtts / 2];
+    net->rttMs = rttMicros / 1000.0f;
+    // Half a round trip to get there, rounded up to whole ticks, plus one
+    // tick for the sender's and receiver's frame timing.
+    float tickMs = 1000.0f / SIM_RATE;
+    net->inputDelay = (int)(net->rttMs / 2 / tickMs + 0.999f) + 1;
+
+    bool acked = false;
+    Uint32 lastSend = 0;
+    for (Uint32 start = SDL_GetTicks(); !acked && SDL_GetTicks() - start < 3000; SDL_Delay(1)) {
+        if (SDL_GetTicks() - lastSend >= RESEND_MS) {
+            PacketOut out = {{0}, 0};
+            put8(&out, PACKET_CONFIG);
+            put8(&out, (Uint8)net->inputDelay);
+            put32(&out, rttMicros);
+            sendPacket(net, &out);
+            lastSend = SDL_GetTicks();
+        }
+        int type;
+        while ((type = receivePacket(net, buffer, &in, false)) != 0) {
+            if (type == PACKET_CONFIG_ACK)
+                acked = true;
+            else
+                handleControl(net, type, &in);
+        }
+    }
+    if (!acked) {
+        printf("The other player does not answer\n");
+        closeNetSession(net);
+        return false;
+    }
+    printf("Player joined: round trip %.2f ms, input delay %d ticks\n", net->rttMs, net->inputDelay);
+    return true;
+}
+
+bool joinNetSession(NetSession* net, const char* host, int port) {
+    if (!openSocket(net, 0))
+        return false;
+    net->isHost = false;
+    net->localPlayer = 1;
+    struct addrinfo hints, *found = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    char portText[16];
+    snprintf(portText, sizeof(portText), "%d", port);
+    if (getaddrinfo(host, portText, &hints, &found) != 0 || found == NULL) {
+        printf("Unknown host %s\n", host);
+        closeNetSession(net);
+        return false;
+    }
+    const struct sockaddr_in* addr = (const struct sockaddr_in*)found->ai_addr;
+    net->peerAddr = addr->sin_addr.s_addr;
+    net->peerPort = addr->sin_port;
+    freeaddrinfo(found);
+
+    printf("Joining %s:%d...\n", host, port);
+    Uint8 buffer[PACKET_MAX];
+    PacketIn in;
+    Uint32 lastHello = 0;
+    bool welcomed = false;
+    for (Uint32 start = SDL_GetTicks(); net->inputDelay == 0 && SDL_GetTicks() - start < 10000; SDL_Delay(1)) {
+        SDL_PumpEvents();
+        if (!welcomed && SDL_GetTicks() - lastHello >= 100) {
+            sendSimple(net, PACKET_HELLO);
+            lastHello = SDL_GetTicks();
+        }
+        int type;
+        while ((type = receivePacket(net, buffer, &in, false)) != 0) {
+            welcomed |= type == PACKET_WELCOME || type == PACKET_PING;
+            handleControl(net, type, &in);
+        }
+    }
+    if (net->inputDelay == 0) {
+        printf("The host does not answer\n");
+        closeNetSession(net);
+        return false;
+    }
+    printf("Joined: round trip %.2f ms, input delay %d ticks\n", net->rttMs, net->inputDelay);
+    return true;
+}
+
+bool syncNetRound(NetSession* net, Uint16 round) {
+    net->round = round;
+    net->roundSeed = 0;
+    net->sentConfirmed = 0;
+    net->remoteConfirmed = 0;
+    net->remoteAcked = 0;
+    net->numOutbox = 0;
+    net->numInbox = 0;
+    net->stalls = 0;
+    net->statsStart = SDL_GetTicks();
+    net->bytesSent = net->bytesReceived = 0;
+    net->packetsSent = net->packetsReceived = 0;
+    Uint8 buffer[PACKET_MAX];
+    PacketIn in;
+    Uint32 lastReady = 0;
+    // The other side may still be reading the menu, so wait a while.
+    for (Uint32 start = SDL_GetTicks(); SDL_GetTicks() - start < 60000; SDL_Delay(1)) {
+        SDL_PumpEvents();
+        if (!net->isHost && SDL_GetTicks() - lastReady >= RESEND_MS) {
+            PacketOut out = {{0}, 0};
+            put8(&out, PACKET_READY);
+            put16(&out, round);
+            sendPacket(net, &out);
+            lastReady = SDL_GetTicks();
+        }
+        int type;
+        while ((type = receivePacket(net, buffer, &in, false)) != 0) {
+            if (type == PACKET_READY && net->isHost && get16(&in) == round) {
+                // Start far enough ahead for the GO to arrive, whatever the link.
+                Uint32 lead = (Uint32)(net->rttMs * 2) + 100;
+                net->roundSeed = (Uint32)SDL_GetPerformanceCounter() | 1u;
+                net->startTicks = SDL_GetTicks() + lead;
+                sendGo(net);
+                return true;
+            }
+            if (type == PACKET_GO && !net->isHost && get16(&in) == round) {
+                net->roundSeed = get32(&in);
+                Sint32 offset = (Sint32)get32(&in);
+                net->startTicks = SDL_GetTicks() + offset - (Sint32)(net->rttMs / 2);
+                return in.ok;
+            }
+            if (!handleControl(net, type, &in))
+                return false;
+        }
+    }
+    printf("The other player did not start the round\n");
+    return false;
+}
+
+bool queueNetInput(NetSession* net, const InputAction* input) {
+    if (net->numOutbox == NET_MAX_INPUTS)
+        return false;
+    net->outbox[net->numOutbox++] = *input;
+    return true;
+}
+
+void sendNetInputs(NetSession* net, Uint32 confirmed) {
+    if (confirmed > net->sentConfirmed)
+        net->sentConfirmed = confirmed;
+    PacketOut out = {{0}, 0};
+    put8(&out, PACKET_INPUT);
+    put16(&out, net->round);
+    put32(&out, net->sentConfirmed);
+    put32(&out, net->remoteConfirmed);
+    put8(&out, (Uint8)net->numOutbox);
+    for (int i = 0; i < net->numOutbox; i++) {
+        put32(&out, net->outbox[i].tick);
+        put8(&out, net->outbox[i].offset);
+        put8(&out, net->outbox[i].kind);
+    }
+    sendPacket(net, &out);
+}
+
+static void receiveInputs(NetSession* net, PacketIn* in) {
+    if (get16(in) != net->round)
+        return; // Left over from the last round.
+    Uint32 confirmed = get32(in);
+    Uint32 ack = get32(in);
+    int n = get8(in);
+    if (!in->ok)
+        return;
+    if (ack > net->remoteAcked) {
+        net->remoteAcked = ack;
+        int kept = 0;
+        for (int i = 0; i < net->numOutbox; i++) {
+            if (net->outbox[i].tick >= ack)
+                net->outbox[kept++] = net->outbox[i];
+        }
+        net->numOutbox = kept;
+    }
+    for (int i = 0; i < n; i++) {
+        InputAction input;
+        input.tick = get32(in);
+        input.offset = get8(in);
+        input.kind = get8(in);
+        input.player = (Uint8)(1 - net->localPlayer);
+        if (!in->ok)
+            return; // Cut short: the promise below may cover commands we did not get.
+        if (input.tick < net->remoteConfirmed)
+            continue; // Already have it.
+        // Field by field: the struct's padding is whatever was on the stack.
+        bool known = false;
+        for (int j = 0; j < net->numInbox && !known; j++) {
+            const InputAction* have = &net->inbox[j];
+            known = have->tick == input.tick && have->offset == input.offset && have->kind == input.kind;
+        }
+        if (known)
+            continue;
+        if (net->numInbox == NET_MAX_INPUTS) {
+            // No room: hold back to just before it. It stays unacknowledged,
+            // so it is sent again once simulating has emptied the inbox.
+            if (confirmed > input.tick)
+                confirmed = input.tick;
+            continue;
+        }
+        net->inbox[net->numInbox++] = input;
+    }
+    if (confirmed > net->remoteConfirmed)
+        net->remoteConfirmed = confirmed;
+}
+
+bool pollNet(NetSession* net) {
+    Uint8 buffer[PACKET_MAX];
+    PacketIn in;
+    int type;
+    while ((type = receivePacket(net, buffer, &in, false)) != 0) {
+        if (type == PACKET_INPUT)
+            receiveInputs(net, &in);
+        else if (!handleControl(net, type, &in))
+            return false;
+    }
+    return SDL_GetTicks() - net->lastHeard < NET_TIMEOUT_MS;
+}
+
+int takeNetInputs(NetSession* net, Uint32 tick, InputAction* out, int max) {
+    int n = 0, kept = 0;
+    for (int i = 0; i < net->numInbox; i++) {
+        if (net->inbox[i].tick == tick && n < max)
+            out[n++] = net->inbox[i];
+        else if (net->inbox[i].tick > tick)
+            net->inbox[kept++] = net->inbox[i];
+    }
+    net->numInbox = kept;
+    return n;
+}
+
+void flushNetRound(NetSession* net, Uint32 endTick) {
+    Uint32 start = SDL_GetTicks();
+    while (net->remoteAcked < endTick && SDL_GetTicks() - start < 1000) {
+        sendNetInputs(net, endTick);
+        if (!pollNet(net))
+            break;
+        SDL_Delay(RESEND_MS / 5);
+    }
+}
+
+void printNetStats(const NetSession* net) {
+    float seconds = (SDL_GetTicks() - net->statsStart) / 1000.0f;
+    if (seconds <= 0)
+        return;
+    printf("Net: sent %u packets (%.0f B/s), received %u (%.0f B/s), round trip %.2f ms, input delay %d ticks, %u stalled frames\n",
+           net->packetsSent, net->bytesSent / seconds, net->packetsReceived, net->bytesReceived / seconds,
+           net->rttMs, net->inputDelay, net->stalls);
+}
+
+void closeNetSession(NetSession* net) {
+    if (net->socket != -1) {
+        if (net->peerPort != 0) {
+            for (int i = 0; i < 3; i++)
+                sendSimple(net, PACKET_BYE);
+        }
+        closeSocket(net->socket);
+    }
+    net->socket = -1;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
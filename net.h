@@ -0,0 +1,81 @@
+#ifndef NET_H
+#define NET_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "input.h"
+
+// Two-player lockstep over UDP. Only player commands cross the wire: each
+// side runs the same deterministic simulation (game.h) and may simulate a
+// tick once it holds the other side's commands for it. A command given at
+// tick t is scheduled for t + inputDelay, where the delay is picked from the
+// round-trip time so the other side normally has it before it is needed.
+
+#define NET_MAX_INPUTS 64     // Commands in flight each way.
+#define NET_TIMEOUT_MS 5000   // Silence after which the other side is gone.
+#define NET_PINGS 8           // Round trips measured when connecting.
+
+typedef struct {
+    intptr_t socket;
+    Uint32 peerAddr;          // Network byte order.
+    Uint16 peerPort;
+    bool isHost;
+    int localPlayer;          // 0 on the host, 1 on the client.
+    int inputDelay;           // Ticks between a key press and the tick it lands in.
+    float rttMs;
+    Uint16 round;
+    Sint32 startOffsetMs;     // Host only: start time of the round relative to now, for late GOs.
+    Uint32 startTicks;
+    Uint32 roundSeed;
+    Uint32 sentConfirmed;     // We have promised no more commands for ticks below this.
+    Uint32 remoteConfirmed;   // We hold all the other side's commands for ticks below this.
+    Uint32 remoteAcked;       // The other side holds all of ours for ticks below this.
+    InputAction outbox[NET_MAX_INPUTS];  // Ours, not yet acknowledged.
+    int numOutbox;
+    InputAction inbox[NET_MAX_INPUTS];   // Theirs, not yet simulated.
+    int numInbox;
+    Uint32 lastHeard;
+    Uint32 statsStart;
+    Uint64 bytesSent, bytesReceived;
+    Uint32 packetsSent, packetsReceived;
+    Uint32 stalls;            // Times the simulation waited on the other side.
+} NetSession;
+
+// Waits for a player to join on `port`, measures the round trip and agrees
+// on the input delay. Returns false on error or after a minute alone.
+bool hostNetSession(NetSession* net, int port);
+
+// Joins a host. Returns false if it does not answer.
+bool joinNetSession(NetSession* net, const char* host, int port);
+
+// Meets the other side before round `round` and agrees on its seed and
+// start time. Returns false if the other side is gone.
+bool syncNetRound(NetSession* net, Uint16 round);
+
+// Queues a local command for sending. It must be for a tick no lower than
+// net->sentConfirmed. Returns false, queueing nothing, if NET_MAX_INPUTS
+// commands are already waiting; the caller must then drop the command
+// locally too.
+bool queueNetInput(NetSession* net, const InputAction* input);
+
+// Sends every unacknowledged command, promising there are no more for ticks
+// below `confirmed`.
+void sendNetInputs(NetSession* net, Uint32 confirmed);
+
+// Reads whatever has arrived. Returns false once the other side is gone.
+bool pollNet(NetSession* net);
+
+// Moves the other side's commands for `tick` into `out`. Only valid once
+// net->remoteConfirmed > tick.
+int takeNetInputs(NetSession* net, Uint32 tick, InputAction* out, int max);
+
+// Keeps sending until the other side holds our commands below `endTick`,
+// so it can finish the round too, or until it stops answering.
+void flushNetRound(NetSession* net, Uint32 endTick);
+
+void printNetStats(const NetSession* net);
+
+void closeNetSession(NetSession* net);
+
+#endif // NET_H
@@ -4,27 +4,100 @@
 #include <SDL.h>
 #include <stdbool.h>
 
-// Define the number of objects
-#define NUM_GOLDS 11
-#define NUM_ROCKS 4
+// Every kind of object the mine can hold. Golds and rocks live in separate
+// arrays, but all behaviour comes from the archetype table below, indexed
+// by kind: adding a kind means adding it here and giving it a row there.
+typedef enum {
+    GOLD_SMALL,
+    GOLD_MEDIUM,
+    GOLD_BIG,
+    GOLD_MYSTERY,
+    ROCK_SMALL,
+    ROCK_BIG,
+    NUM_OBJECT_KINDS
+} ObjectKind;
 
-// Define gold types.
-typedef enum { GOLD_SMALL, GOLD_MEDIUM, GOLD_BIG, GOLD_MYSTERY } GoldType;
+// Sprites objects are drawn with, and the files they load from.
+typedef enum { SPRITE_GOLD, SPRITE_MYSTERY, SPRITE_ROCK, NUM_OBJECT_SPRITES } ObjectSprite;
 
-// Define rock types.
-typedef enum { ROCK_SMALL, ROCK_BIG } RockType;
+inline constexpr const char* OBJECT_SPRITE_FILES[NUM_OBJECT_SPRITES] = {"gold.png", "mysbag.png", "rock.png"};
+
+// What a catch pays out. A kind with several outcomes rolls 0-99 and gets
+// the first outcome whose `below` is above the roll.
+typedef struct {
+    int below;
+    int points;
+    int dynamites;
+} ObjectOutcome;
+
+#define MAX_OBJECT_OUTCOMES 3
+
+typedef struct {
+    const char* name;         // In level files, after "gold" or "rock".
+    bool isRock;              // Which array the kind is stored in.
+    float retractScale;       // Retract speed as a fraction of the level's pullSpeed.
+    ObjectSprite sprite;
+    int size;                 // Side of the square the generator places.
+    int numOutcomes;
+    ObjectOutcome outcomes[MAX_OBJECT_OUTCOMES];
+} ObjectArchetype;
+
+inline constexpr ObjectArchetype OBJECT_ARCHETYPES[NUM_OBJECT_KINDS] = {
+    {"small",   false, 1.0f, SPRITE_GOLD,    20, 1, {{100, 50, 0}}},
+    {"medium",  false, 1.0f, SPRITE_GOLD,    30, 1, {{100, 100, 0}}},
+    {"big",     false, 1.0f, SPRITE_GOLD,    60, 1, {{100, 200, 0}}},
+    {"mystery", false, 1.0f, SPRITE_MYSTERY, 40, 3, {{30, 0, 1}, {90, 100, 0}, {100, 250, 0}}},
+    {"small",   true,  0.5f, SPRITE_ROCK,    30, 1, {{100, 10, 0}}},
+    {"big",     true,  0.5f, SPRITE_ROCK,    50, 1, {{100, 20, 0}}},
+};
+
+// Average points of a catch; dynamite counts for nothing.
+constexpr float expectedPoints(ObjectKind kind) {
+    const ObjectArchetype& a = OBJECT_ARCHETYPES[kind];
+    float points = 0.0f;
+    int from = 0;
+    for (int i = 0; i < a.numOutcomes; i++) {
+        points += a.outcomes[i].points * (a.outcomes[i].below - from) / 100.0f;
+        from = a.outcomes[i].below;
+    }
+    return points;
+}
+
+constexpr int largestObjectSize() {
+    int size = 0;
+    for (const ObjectArchetype& a : OBJECT_ARCHETYPES)
+        size = a.size > size ? a.size : size;
+    return size;
+}
+
+constexpr int smallestObjectSize() {
+    int size = OBJECT_ARCHETYPES[0].size;
+    for (const ObjectArchetype& a : OBJECT_ARCHETYPES)
+        size = a.size < size ? a.size : size;
+    return size;
+}
+
+// Every roll must land on an outcome.
+constexpr bool archetypesValid() {
+    for (const ObjectArchetype& a : OBJECT_ARCHETYPES) {
+        if (a.numOutcomes < 1 || a.numOutcomes > MAX_OBJECT_OUTCOMES || a.outcomes[a.numOutcomes - 1].below != 100)
+            return false;
+    }
+    return true;
+}
+static_assert(archetypesValid(), "every archetype's last outcome must cover rolls up to 100");
 
 // Structure for a gold object.
 typedef struct {
     SDL_Rect rect;
-    GoldType type;
+    ObjectKind type;
     bool active;
 } GoldObject;
 
 // Structure for a rock object.
 typedef struct {
     SDL_Rect rect;
-    RockType type;
+    ObjectKind type;
     bool active;
 } RockObject;
 
@@ -0,0 +1,182 @@
+#include "particles.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PI 3.14159265358979323846
+
+// How each kind behaves. Gravity is in px/s^2 (dust rises), drag is the
+// fraction of speed lost per second.
+typedef struct {
+    int capacity;
+    int burst;                // Spawned per explosion.
+    float gravity;
+    float drag;
+    float minSpeed, maxSpeed;
+    float minLife, maxLife;
+    float minSize, maxSize;
+    SDL_Color color;
+} ParticleStyle;
+
+static const ParticleStyle styles[NUM_PARTICLE_KINDS] = {
+    {8192,  60,  900.0f, 0.5f, 150.0f, 450.0f, 0.6f, 1.2f, 2.0f, 4.0f, {110, 80, 50, 255}},   // Debris
+    {16384, 120, 300.0f, 2.0f, 300.0f, 800.0f, 0.2f, 0.5f, 1.0f, 2.0f, {255, 210, 90, 255}},  // Sparks
+    {8192,  40,  -30.0f, 3.0f, 30.0f,  120.0f, 0.8f, 1.6f, 4.0f, 8.0f, {150, 140, 130, 255}}, // Dust
+};
+
+// Number of float arrays in a pool.
+#define POOL_FIELDS 7
+
+static float randomRange(Uint32* state, float lo, float hi) {
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return lo + (hi - lo) * (x >> 8) * (1.0f / 16777216.0f);
+}
+
+bool initParticles(Particles* particles) {
+    int total = 0;
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++)
+        total += styles[k].capacity;
+    size_t size = sizeof(float) * POOL_FIELDS * total + sizeof(SDL_Vertex) * 4 * total + sizeof(int) * 6 * total;
+    particles->memory = malloc(size);
+    if (particles->memory == NULL) {
+        // Leave empty pools behind so the rest of the calls do nothing.
+        printf("Failed to allocate %d particles\n", total);
+        for (int k = 0; k < NUM_PARTICLE_KINDS; k++)
+            particles->pools[k].count = particles->pools[k].capacity = 0;
+        particles->capacity = 0;
+        return false;
+    }
+    float* next = (float*)particles->memory;
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++) {
+        ParticlePool* pool = &particles->pools[k];
+        int n = styles[k].capacity;
+        pool->count = 0;
+        pool->capacity = n;
+        pool->x = next;
+        pool->y = next + n;
+        pool->vx = next + 2 * n;
+        pool->vy = next + 3 * n;
+        pool->age = next + 4 * n;
+        pool->life = next + 5 * n;
+        pool->size = next + 6 * n;
+        next += POOL_FIELDS * n;
+    }
+    particles->vertices = (SDL_Vertex*)next;
+    particles->indices = (int*)(particles->vertices + 4 * total);
+    // Quads are untextured, so only positions and colours change per draw.
+    for (int i = 0; i < 4 * total; i++)
+        particles->vertices[i].tex_coord = (SDL_FPoint){0.0f, 0.0f};
+    for (int i = 0; i < total; i++) {
+        int* q = particles->indices + 6 * i;
+        q[0] = 4 * i;
+        q[1] = 4 * i + 1;
+        q[2] = 4 * i + 2;
+        q[3] = 4 * i;
+        q[4] = 4 * i + 2;
+        q[5] = 4 * i + 3;
+    }
+    particles->capacity = total;
+    particles->rng = 0x2545F491u;
+    return true;
+}
+
+void spawnExplosion(Particles* particles, float x, float y) {
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++) {
+        ParticlePool* pool = &particles->pools[k];
+        const ParticleStyle* style = &styles[k];
+        for (int n = 0; n < style->burst && pool->count < pool->capacity; n++) {
+            int i = pool->count++;
+            float angle = randomRange(&particles->rng, 0.0f, 2.0f * PI);
+            float speed = randomRange(&particles->rng, style->minSpeed, style->maxSpeed);
+            pool->x[i] = x;
+            pool->y[i] = y;
+            pool->vx[i] = speed * cosf(angle);
+            pool->vy[i] = speed * sinf(angle);
+            pool->age[i] = 0.0f;
+            pool->life[i] = randomRange(&particles->rng, style->minLife, style->maxLife);
+            pool->size[i] = randomRange(&particles->rng, style->minSize, style->maxSize);
+        }
+    }
+}
+
+// The integration step has no branches and no aliasing, so the compiler
+// can turn it into SIMD.
+static void integratePool(ParticlePool* pool, float gravity, float damp, float dt) {
+    float* __restrict x = pool->x;
+    float* __restrict y = pool->y;
+    float* __restrict vx = pool->vx;
+    float* __restrict vy = pool->vy;
+    float* __restrict age = pool->age;
+    int n = pool->count;
+    for (int i = 0; i < n; i++) {
+        vx[i] *= damp;
+        vy[i] = vy[i] * damp + gravity * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+}
+
+void updateParticles(Particles* particles, float dt) {
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++) {
+        ParticlePool* pool = &particles->pools[k];
+        float damp = 1.0f - styles[k].drag * dt;
+        integratePool(pool, styles[k].gravity, damp > 0.0f ? damp : 0.0f, dt);
+        // Expired particles are replaced by the last live one.
+        int i = 0;
+        while (i < pool->count) {
+            if (pool->age[i] < pool->life[i]) {
+                i++;
+                continue;
+            }
+            int last = --pool->count;
+            pool->x[i] = pool->x[last];
+            pool->y[i] = pool->y[last];
+            pool->vx[i] = pool->vx[last];
+            pool->vy[i] = pool->vy[last];
+            pool->age[i] = pool->age[last];
+            pool->life[i] = pool->life[last];
+            pool->size[i] = pool->size[last];
+        }
+    }
+}
+
+void drawParticles(Particles* particles, SDL_Renderer* renderer, float cameraY) {
+    SDL_Vertex* v = particles->vertices;
+    int numQuads = 0;
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++) {
+        const ParticlePool* pool = &particles->pools[k];
+        SDL_Color color = styles[k].color;
+        for (int i = 0; i < pool->count; i++) {
+            // Fade out over the particle's life.
+            color.a = (Uint8)(255.0f * (1.0f - pool->age[i] / pool->life[i]));
+            float x = pool->x[i], y = pool->y[i] - cameraY, s = pool->size[i];
+            v[0].position = (SDL_FPoint){x - s, y - s};
+            v[1].position = (SDL_FPoint){x + s, y - s};
+            v[2].position = (SDL_FPoint){x + s, y + s};
+            v[3].position = (SDL_FPoint){x - s, y + s};
+            v[0].color = v[1].color = v[2].color = v[3].color = color;
+            v += 4;
+        }
+        numQuads += pool->count;
+    }
+    if (numQuads == 0)
+        return;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, NULL, particles->vertices, 4 * numQuads, particles->indices, 6 * numQuads);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+void clearParticles(Particles* particles) {
+    for (int k = 0; k < NUM_PARTICLE_KINDS; k++)
+        particles->pools[k].count = 0;
+}
+
+void freeParticles(Particles* particles) {
+    free(particles->memory);
+    particles->memory = NULL;
+}
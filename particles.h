@@ -0,0 +1,55 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Explosion particles. Each kind lives in its own pool of parallel arrays
+// (one per field) sized once at startup, so spawning never allocates and
+// the update loops run straight down contiguous floats. Everything is drawn
+// as coloured quads in a single SDL_RenderGeometry call.
+//
+// Particles are only decoration: they are not part of the game state and
+// do not need to match between players.
+
+typedef enum { PARTICLE_DEBRIS, PARTICLE_SPARK, PARTICLE_DUST, NUM_PARTICLE_KINDS } ParticleKind;
+
+typedef struct {
+    int count;
+    int capacity;
+    float* x;                 // Centre, in mine coordinates.
+    float* y;
+    float* vx;
+    float* vy;
+    float* age;               // Seconds since spawning.
+    float* life;              // Seconds it lasts.
+    float* size;              // Half the quad's side.
+} ParticlePool;
+
+typedef struct {
+    ParticlePool pools[NUM_PARTICLE_KINDS];
+    SDL_Vertex* vertices;     // Four per particle, rebuilt every draw.
+    int* indices;             // Six per particle, fixed.
+    int capacity;             // All pools together.
+    Uint32 rng;
+    void* memory;             // The single allocation behind all of the above.
+} Particles;
+
+// Allocates every pool up front. On failure the pools are left empty and
+// the other calls do nothing.
+bool initParticles(Particles* particles);
+
+// Throws out a burst of debris, sparks and dust from (x, y). When a pool is
+// full the rest of its share is dropped.
+void spawnExplosion(Particles* particles, float x, float y);
+
+// Moves every particle on by dt seconds and drops the expired ones.
+void updateParticles(Particles* particles, float dt);
+
+// Draws the live particles, shifted up by cameraY.
+void drawParticles(Particles* particles, SDL_Renderer* renderer, float cameraY);
+
+void clearParticles(Particles* particles);
+void freeParticles(Particles* particles);
+
+#endif // PARTICLES_H
@@ -0,0 +1,164 @@
+#include "perf_counters.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* PHASE_NAMES[NUM_PERF_PHASES] = {"idle", "events", "update", "collision", "render"};
+
+// Per thread: each thread that marks phases opens and reports its own.
+static thread_local bool counting;
+static thread_local PerfPhase current;
+static thread_local Uint64 lastValues[NUM_PERF_COUNTERS];
+static thread_local Uint64 lastTime;
+
+typedef struct {
+    Uint64 counts[NUM_PERF_PHASES][NUM_PERF_COUNTERS];
+    Uint64 time[NUM_PERF_PHASES];
+    int frames;
+} PerfTotals;
+
+static thread_local PerfTotals sinceReport, wholeRun;
+
+#ifdef __linux__
+static thread_local int fds[NUM_PERF_COUNTERS] = {-1, -1, -1, -1};
+
+// What a read of the group leader returns with the format set below.
+typedef struct {
+    Uint64 nr;
+    Uint64 timeEnabled;
+    Uint64 timeRunning;
+    Uint64 values[NUM_PERF_COUNTERS];
+} GroupReading;
+
+static int openCounter(Uint32 type, Uint64 config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;  // The leader starts the whole group.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+// One read for all four counters. If the kernel had to share the hardware
+// with other users, the counts are scaled up to the whole time.
+static bool readCounters(Uint64* values) {
+    GroupReading reading;
+    if (read(fds[0], &reading, sizeof(reading)) != (ssize_t)sizeof(reading) || reading.nr != NUM_PERF_COUNTERS)
+        return false;
+    double scale = reading.timeRunning > 0 ? (double)reading.timeEnabled / reading.timeRunning : 1.0;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++)
+        values[i] = (Uint64)(reading.values[i] * scale);
+    return true;
+}
+#endif
+
+
+bool openPerfCounters(void) {
+#ifdef __linux__
+    if (counting)
+        return true;
+    fds[PERF_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (fds[PERF_CYCLES] >= 0) {
+        int leader = fds[PERF_CYCLES];
+        fds[PERF_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader);
+        // Last-level cache read misses; the generic cache-miss event is the
+        // same thing on most CPUs and the fallback on the rest.
+        fds[PERF_LLC_MISSES] = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), leader);
+        if (fds[PERF_LLC_MISSES] < 0)
+            fds[PERF_LLC_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader);
+        fds[PERF_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, leader);
+    }
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (fds[i] < 0) {
+            printf("Performance counters unavailable (%s); check /proc/sys/kernel/perf_event_paranoid\n", strerror(errno));
+            closePerfCounters();
+            return false;
+        }
+    }
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    if (!readCounters(lastValues)) {
+        printf("Performance counters could not be read\n");
+        closePerfCounters();
+        return false;
+    }
+    lastTime = SDL_GetPerformanceCounter();
+    current = PERF_IDLE;
+    memset(&sinceReport, 0, sizeof(sinceReport));
+    memset(&wholeRun, 0, sizeof(wholeRun));
+    counting = true;
+    return true;
+#else
+    printf("Performance counters are only available on Linux\n");
+    return false;
+#endif
+}
+
+void closePerfCounters(void) {
+#ifdef __linux__
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (fds[i] >= 0)
+            close(fds[i]);
+        fds[i] = -1;
+    }
+#endif
+    counting = false;
+}
+
+PerfPhase beginPerfPhase(PerfPhase phase) {
+    PerfPhase ended = current;
+    if (!counting)
+        return ended;
+#ifdef __linux__
+    Uint64 values[NUM_PERF_COUNTERS];
+    if (!readCounters(values))
+        return ended;
+    Uint64 now = SDL_GetPerformanceCounter();
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        sinceReport.counts[current][i] += values[i] - lastValues[i];
+        wholeRun.counts[current][i] += values[i] - lastValues[i];
+        lastValues[i] = values[i];
+    }
+    sinceReport.time[current] += now - lastTime;
+    wholeRun.time[current] += now - lastTime;
+    lastTime = now;
+    if (phase == PERF_EVENTS) {
+        sinceReport.frames++;
+        wholeRun.frames++;
+    }
+    current = phase;
+#else
+    (void)phase;
+#endif
+    return ended;
+}
+
+void printPerfPhases(const char* title, bool run) {
+    if (!counting)
+        return;
+    PerfTotals* totals = run ? &wholeRun : &sinceReport;
+    int frames = totals->frames > 0 ? totals->frames : 1;
+    printf("%s: %d frames\n", title, totals->frames);
+    printf("  %-10s %9s %10s %6s %9s %12s\n", "phase", "ms/frame", "Mcycles", "IPC", "LLC MPKI", "branch MPKI");
+    double freq = (double)SDL_GetPerformanceFrequency();
+    for (int p = PERF_EVENTS; p < NUM_PERF_PHASES; p++) {
+        const Uint64* t = totals->counts[p];
+        double instructions = t[PERF_INSTRUCTIONS] > 0 ? (double)t[PERF_INSTRUCTIONS] : 1.0;
+        printf("  %-10s %9.3f %10.1f %6.2f %9.2f %12.2f\n", PHASE_NAMES[p], totals->time[p] * 1000.0 / freq / frames,
+               t[PERF_CYCLES] / 1e6, t[PERF_CYCLES] > 0 ? t[PERF_INSTRUCTIONS] / (double)t[PERF_CYCLES] : 0.0,
+               t[PERF_LLC_MISSES] * 1000.0 / instructions, t[PERF_BRANCH_MISSES] * 1000.0 / instructions);
+    }
+    if (!run)
+        memset(&sinceReport, 0, sizeof(sinceReport));
+}
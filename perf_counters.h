@@ -0,0 +1,44 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Hardware performance counters per phase of the session loop, through
+// Linux perf_event_open. The loop marks where each phase starts; the
+// counters read at a mark are charged to the phase that just ended. Only
+// the calling thread is counted, in user mode, so it works with the
+// default perf_event_paranoid setting. Everything here is per thread: a
+// thread opens, marks, prints and closes its own counters. Elsewhere openPerfCounters fails and
+// the marks do nothing.
+
+typedef enum {
+    PERF_IDLE,                // Waiting for the next frame; not reported.
+    PERF_EVENTS,              // Polling SDL events and stamping input.
+    PERF_UPDATE,              // Simulation, networking, particles and sound.
+    PERF_COLLISION,           // Hook against the mine, inside stepGame.
+    PERF_RENDER,              // Drawing and presenting.
+    NUM_PERF_PHASES
+} PerfPhase;
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_COUNTERS
+} PerfCounter;
+
+bool openPerfCounters(void);
+void closePerfCounters(void);
+
+// Ends the current phase and starts `phase`, returning the phase that
+// ended so a nested phase can hand back to it. Returns at once when the
+// counters are not open.
+PerfPhase beginPerfPhase(PerfPhase phase);
+
+// Prints time, IPC and miss rates (per thousand instructions) per phase,
+// either since the last report or for the whole run.
+void printPerfPhases(const char* title, bool run);
+
+#endif // PERF_COUNTERS_H
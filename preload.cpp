@@ -0,0 +1,118 @@
+#include "preload.h"
+#include "level_gen.h"
+#include "alloc_track.h"
+#include <stdio.h>
+#include <string.h>
+
+static int preloadWorker(void* data) {
+    RoundPreload* preload = (RoundPreload*)data;
+    RoundData* round = &preload->round;
+    char path[LEVEL_PATH_LEN];
+    // Past the last authored level the game goes on with generated ones.
+    if (findLevelFile(round->levelIndex, path, sizeof(path)))
+        preload->failed = !loadLevel(path, &round->level, round->arena);
+    else
+        preload->failed = !generateEndlessLevel(round->levelIndex, &round->level, round->arena);
+    if (preload->failed) {
+        SDL_AtomicSet(&preload->workerStep, PRELOAD_UPLOAD);
+        return 1;
+    }
+    SDL_AtomicSet(&preload->workerStep, PRELOAD_DECODE);
+    const char* background = round->level.header->background;
+    preload->backgroundSurface = trackedLoadImage(background);
+    if (!preload->backgroundSurface)
+        printf("Error loading %s: %s\n", background, IMG_GetError());
+    else if (preload->rasterImage)
+        initRasterImage(&round->backgroundImage, preload->backgroundSurface, round->arena);
+    SDL_AtomicSet(&preload->workerStep, PRELOAD_UPLOAD);
+    return 0;
+}
+
+void startRoundPreload(RoundPreload* preload, int levelIndex, bool rasterImage, Arena* arena) {
+    memset(preload, 0, sizeof(RoundPreload));
+    preload->round.levelIndex = levelIndex;
+    preload->round.arena = arena;
+    preload->rasterImage = rasterImage;
+    preload->mainStep = PRELOAD_UPLOAD;
+    preload->startTicks = SDL_GetTicks();
+    SDL_AtomicSet(&preload->workerStep, PRELOAD_LEVEL);
+    preload->thread = SDL_CreateThread(preloadWorker, "preload", preload);
+    if (!preload->thread) {
+        // No thread available; do the worker's share right here instead.
+        printf("Preload thread error: %s\n", SDL_GetError());
+        preloadWorker(preload);
+    }
+}
+
+bool roundLevelReady(RoundPreload* preload) {
+    return SDL_AtomicGet(&preload->workerStep) >= PRELOAD_DECODE && !preload->failed;
+}
+
+bool pumpRoundPreload(RoundPreload* preload, SDL_Renderer* renderer) {
+    if (preload->mainStep == PRELOAD_DONE)
+        return true;
+    if (SDL_AtomicGet(&preload->workerStep) < PRELOAD_UPLOAD)
+        return false;
+    if (preload->thread) {
+        SDL_WaitThread(preload->thread, NULL);
+        preload->thread = NULL;
+    }
+    if (preload->failed) {
+        preload->mainStep = PRELOAD_DONE;
+        preload->readyTicks = SDL_GetTicks();
+        return true;
+    }
+    if (preload->mainStep == PRELOAD_UPLOAD) {
+        if (preload->backgroundSurface) {
+            preload->round.background = trackedCreateTextureFromSurface(renderer, preload->backgroundSurface);
+            trackedFreeSurface(preload->backgroundSurface);
+            preload->backgroundSurface = NULL;
+        }
+        preload->mainStep = PRELOAD_DONE;
+        preload->readyTicks = SDL_GetTicks();
+    }
+    return preload->mainStep == PRELOAD_DONE;
+}
+
+float roundPreloadProgress(RoundPreload* preload) {
+    int done = SDL_AtomicGet(&preload->workerStep) + (preload->mainStep - PRELOAD_UPLOAD);
+    return (float)done / (float)PRELOAD_DONE;
+}
+
+bool finishRoundPreload(RoundPreload* preload, SDL_Renderer* renderer, RoundData* out) {
+    bool waited = false;
+    while (!pumpRoundPreload(preload, renderer)) {
+        if (SDL_AtomicGet(&preload->workerStep) < PRELOAD_UPLOAD)
+            SDL_Delay(1);
+        waited = true;
+    }
+    if (waited)
+        printf("Round preload was not finished in time (%u ms total)\n", preload->readyTicks - preload->startTicks);
+    if (preload->failed) {
+        freeRoundData(&preload->round);
+        return false;
+    }
+    *out = preload->round;
+    memset(&preload->round, 0, sizeof(RoundData));
+    return true;
+}
+
+void cancelRoundPreload(RoundPreload* preload) {
+    if (preload->thread) {
+        SDL_WaitThread(preload->thread, NULL);
+        preload->thread = NULL;
+    }
+    trackedFreeSurface(preload->backgroundSurface);
+    preload->backgroundSurface = NULL;
+    freeRoundData(&preload->round);
+    preload->mainStep = PRELOAD_DONE;
+}
+
+void freeRoundData(RoundData* round) {
+    if (round->level.block)
+        freeLevel(&round->level);
+    if (round->background)
+        trackedDestroyTexture(round->background);
+    round->background = NULL;
+    freeRasterImage(&round->backgroundImage);
+}
@@ -0,0 +1,63 @@
+#ifndef PRELOAD_H
+#define PRELOAD_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "level.h"
+#include "soft_raster.h"
+
+// Everything that changes from one round to the next.
+typedef struct {
+    int levelIndex;
+    Arena* arena;             // Holds the level and background image; NULL for the heap.
+    Level level;
+    SDL_Texture* background;
+    RasterImage backgroundImage;  // Only with rasterImage.
+} RoundData;
+
+// Preload steps, in order. The first two run on the worker thread; the rest
+// touch the renderer and run on the main thread.
+typedef enum {
+    PRELOAD_LEVEL,            // Read the level file, or generate the level.
+    PRELOAD_DECODE,           // Decode the level background into a surface.
+    PRELOAD_UPLOAD,           // Turn the surface into a texture.
+    PRELOAD_DONE
+} PreloadStep;
+
+// Prepares the next round in the background while a transition screen is up.
+typedef struct {
+    SDL_Thread* thread;
+    SDL_atomic_t workerStep;  // First step the worker has not finished yet.
+    int mainStep;             // First step the main thread has not finished yet.
+    bool failed;
+    bool rasterImage;         // Also keep the background for the soft raster.
+    SDL_Surface* backgroundSurface;
+    RoundData round;
+    Uint32 startTicks;
+    Uint32 readyTicks;
+} RoundPreload;
+
+// Starts loading level `levelIndex` on a worker thread, into `arena`, which
+// the round has to itself until it is over.
+void startRoundPreload(RoundPreload* preload, int levelIndex, bool rasterImage, Arena* arena);
+
+// True once the level data itself (tuning, target, objects) is available.
+bool roundLevelReady(RoundPreload* preload);
+
+// Runs at most one main-thread step. Call once per frame of a transition
+// screen. Returns true once everything is ready.
+bool pumpRoundPreload(RoundPreload* preload, SDL_Renderer* renderer);
+
+// Fraction of steps completed, 0..1.
+float roundPreloadProgress(RoundPreload* preload);
+
+// Finishes any outstanding work (blocking only if there is some) and hands
+// the round over to the caller, who then owns it. Returns false on failure.
+bool finishRoundPreload(RoundPreload* preload, SDL_Renderer* renderer, RoundData* out);
+
+// Waits for the worker and frees whatever it produced.
+void cancelRoundPreload(RoundPreload* preload);
+
+void freeRoundData(RoundData* round);
+
+#endif // PRELOAD_H
@@ -0,0 +1,67 @@
+#include "render_scale.h"
+#include <stdio.h>
+#include "alloc_track.h"
+
+bool initRenderScaler(RenderScaler* scaler, SDL_Renderer* renderer, int width, int height, float budgetMs) {
+    scaler->width = width;
+    scaler->height = height;
+    scaler->scale = 1.0f;
+    scaler->budgetMs = budgetMs > 0 ? budgetMs : SCALE_DEFAULT_BUDGET_MS;
+    scaler->numSamples = 0;
+    scaler->target = trackedCreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (scaler->target == NULL) {
+        printf("Error creating render target: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureScaleMode(scaler->target, SDL_ScaleModeLinear);
+    return true;
+}
+
+void beginScaledFrame(RenderScaler* scaler, SDL_Renderer* renderer) {
+    if (scaler->target == NULL) {
+        SDL_RenderClear(renderer);
+        return;
+    }
+    SDL_SetRenderTarget(renderer, scaler->target);
+    // The scale belongs to the target, so it resets when the target does.
+    SDL_RenderSetScale(renderer, scaler->scale, scaler->scale);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+}
+
+void endScaledFrame(RenderScaler* scaler, SDL_Renderer* renderer) {
+    if (scaler->target == NULL)
+        return;
+    SDL_SetRenderTarget(renderer, NULL);
+    SDL_Rect used = {0, 0, (int)(scaler->width * scaler->scale + 0.5f), (int)(scaler->height * scaler->scale + 0.5f)};
+    SDL_RenderCopy(renderer, scaler->target, &used, NULL);
+}
+
+void recordFrameTime(RenderScaler* scaler, float ms) {
+    scaler->samples[scaler->numSamples++] = ms;
+    if (scaler->numSamples < SCALE_WINDOW)
+        return;
+    // Decide once per full window, then start a fresh one, so every change
+    // is judged on frames rendered at the current scale.
+    float total = 0.0f;
+    for (int i = 0; i < SCALE_WINDOW; i++)
+        total += scaler->samples[i];
+    float average = total / SCALE_WINDOW;
+    scaler->numSamples = 0;
+    if (average > scaler->budgetMs && scaler->scale > SCALE_MIN) {
+        scaler->scale -= SCALE_STEP;
+        if (scaler->scale < SCALE_MIN)
+            scaler->scale = SCALE_MIN;
+    } else if (average < scaler->budgetMs * 0.6f && scaler->scale < 1.0f) {
+        // Wide gap between the two thresholds so the scale does not flicker.
+        scaler->scale += SCALE_STEP;
+        if (scaler->scale > 1.0f)
+            scaler->scale = 1.0f;
+    }
+}
+
+void freeRenderScaler(RenderScaler* scaler) {
+    if (scaler->target != NULL)
+        trackedDestroyTexture(scaler->target);
+    scaler->target = NULL;
+}
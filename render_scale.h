@@ -0,0 +1,44 @@
+#ifndef RENDER_SCALE_H
+#define RENDER_SCALE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// Frames averaged before the scale may change, and how far it moves per change.
+#define SCALE_WINDOW 30
+#define SCALE_STEP 0.125f
+#define SCALE_MIN 0.5f
+
+// CPU time per frame the scaler aims to stay under, in milliseconds.
+#define SCALE_DEFAULT_BUDGET_MS 12.0f
+
+// Draws the playfield into an offscreen target at a fraction of the window
+// size and stretches it up. All drawing still uses 1366x768 logical
+// coordinates; only the pixels behind them change. The fraction follows
+// the measured frame time: it drops while frames run over budget and
+// climbs back once there is room.
+typedef struct {
+    SDL_Texture* target;      // Full window size; only the top-left scale part is used.
+    int width, height;
+    float scale;
+    float budgetMs;
+    float samples[SCALE_WINDOW];
+    int numSamples;
+} RenderScaler;
+
+// On failure the scaler still works, drawing straight to the window.
+bool initRenderScaler(RenderScaler* scaler, SDL_Renderer* renderer, int width, int height, float budgetMs);
+
+// Redirects drawing into the offscreen target and clears it.
+void beginScaledFrame(RenderScaler* scaler, SDL_Renderer* renderer);
+
+// Stretches the offscreen target over the window. Anything drawn after this
+// (the HUD) lands on the window at full resolution.
+void endScaledFrame(RenderScaler* scaler, SDL_Renderer* renderer);
+
+// Feeds in the time one frame took, excluding any sleep, and adjusts the scale.
+void recordFrameTime(RenderScaler* scaler, float ms);
+
+void freeRenderScaler(RenderScaler* scaler);
+
+#endif // RENDER_SCALE_H
@@ -0,0 +1,245 @@
+#include "replay.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "mine.h"
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+// FNV-1a, a byte at a time over a 32-bit word.
+static Uint32 hashWord(Uint32 hash, Uint32 word) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (word >> (8 * i)) & 0xFF;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static Uint32 hashFloat(Uint32 hash, float value) {
+    Uint32 word;
+    memcpy(&word, &value, sizeof(word));
+    return hashWord(hash, word);
+}
+
+static Uint32 hashObject(const SDL_Rect* rect, ObjectKind kind) {
+    Uint32 hash = FNV_OFFSET;
+    hash = hashWord(hash, (Uint32)rect->x);
+    hash = hashWord(hash, (Uint32)rect->y);
+    hash = hashWord(hash, (Uint32)rect->w);
+    hash = hashWord(hash, (Uint32)rect->h);
+    return hashWord(hash, (Uint32)kind);
+}
+
+// Everything that plays a part in the round. The objects are summed, as
+// initMine sorts them in place; the background is only for show.
+static Uint32 hashLevel(const Level* level) {
+    const LevelHeader* h = level->header;
+    Uint32 hash = FNV_OFFSET;
+    hash = hashWord(hash, (Uint32)h->charRect.x);
+    hash = hashWord(hash, (Uint32)h->charRect.y);
+    hash = hashWord(hash, (Uint32)h->charRect.w);
+    hash = hashWord(hash, (Uint32)h->charRect.h);
+    hash = hashFloat(hash, h->baseR);
+    hash = hashFloat(hash, h->maxAngleDeg);
+    hash = hashFloat(hash, h->periodMs);
+    hash = hashFloat(hash, h->droppingSpeed);
+    hash = hashFloat(hash, h->pullSpeed);
+    hash = hashFloat(hash, h->timeLimit);
+    hash = hashWord(hash, (Uint32)h->target);
+    hash = hashWord(hash, (Uint32)h->numGolds);
+    hash = hashWord(hash, (Uint32)h->numRocks);
+    hash = hashWord(hash, (Uint32)h->depth);
+    hash = hashWord(hash, h->mineSeed);
+    Uint32 objects = 0;
+    for (int i = 0; i < h->numGolds; i++)
+        objects += hashObject(&level->golds[i].rect, level->golds[i].type);
+    for (int i = 0; i < h->numRocks; i++)
+        objects += hashObject(&level->rocks[i].rect, level->rocks[i].type);
+    return hashWord(hash, objects);
+}
+
+// Writes the reason for a rejection and returns false.
+static bool reject(char* reason, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(reason, REPLAY_REASON_LEN, format, args);
+    va_end(args);
+    return false;
+}
+
+void beginReplay(Replay* replay, int levelIndex, const Level* level, Uint32 seed, int numPlayers, int player) {
+    ReplayHeader* h = &replay->header;
+    memset(h, 0, sizeof(ReplayHeader));
+    h->magic = REPLAY_MAGIC;
+    h->version = REPLAY_VERSION;
+    h->inputSize = (Uint16)sizeof(InputAction);
+    h->levelIndex = (Uint32)levelIndex;
+    h->levelHash = hashLevel(level);
+    h->seed = seed;
+    h->numPlayers = (Uint8)numPlayers;
+    h->player = (Uint8)player;
+    replay->overflow = false;
+}
+
+void recordReplayInputs(Replay* replay, const InputAction* inputs, int numInputs) {
+    ReplayHeader* h = &replay->header;
+    if (h->numInputs + (Uint32)numInputs > REPLAY_MAX_INPUTS) {
+        replay->overflow = true;
+        return;
+    }
+    memcpy(replay->inputs + h->numInputs, inputs, sizeof(InputAction) * numInputs);
+    h->numInputs += numInputs;
+}
+
+void rewindReplay(Replay* replay, Uint32 tick) {
+    ReplayHeader* h = &replay->header;
+    while (h->numInputs > 0 && replay->inputs[h->numInputs - 1].tick >= tick)
+        h->numInputs--;
+    if (h->rewinds < 0xFFFF)
+        h->rewinds++;
+}
+
+bool saveReplay(const char* path, Replay* replay, const Game* game) {
+    ReplayHeader* h = &replay->header;
+    if (replay->overflow) {
+        printf("Too many inputs to save the replay\n");
+        return false;
+    }
+    if (h->rewinds > 0) {
+        printf("The round went back in time, so its replay is not saved\n");
+        return false;
+    }
+    if (h->levelIndex > REPLAY_MAX_LEVEL) {
+        printf("Replays only go up to level %d\n", REPLAY_MAX_LEVEL);
+        return false;
+    }
+    const PlayerState* p = &game->players[h->player];
+    h->ticks = game->tick;
+    h->score = p->score;
+    h->dynamites = p->dynamites;
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error opening %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(h, sizeof(ReplayHeader), 1, file) == 1 &&
+              fwrite(replay->inputs, sizeof(InputAction), h->numInputs, file) == h->numInputs;
+    if (fclose(file) != 0 || !ok) {
+        printf("Error writing %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+bool loadReplay(const char* path, Replay* replay, char* reason) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return reject(reason, "cannot be opened");
+    ReplayHeader* h = &replay->header;
+    bool ok = false;
+    if (fread(h, sizeof(ReplayHeader), 1, file) != 1)
+        reject(reason, "too short");
+    else if (h->magic != REPLAY_MAGIC || h->version != REPLAY_VERSION || h->inputSize != sizeof(InputAction))
+        reject(reason, "not a version %d replay", REPLAY_VERSION);
+    else if (h->levelIndex < 1 || h->levelIndex > REPLAY_MAX_LEVEL)
+        reject(reason, "level %u is not one a replay can name", h->levelIndex);
+    else if (h->numInputs > REPLAY_MAX_INPUTS)
+        reject(reason, "%u inputs, more than a round can hold", h->numInputs);
+    else if (fread(replay->inputs, sizeof(InputAction), h->numInputs, file) != h->numInputs)
+        reject(reason, "cut short");
+    else if (fgetc(file) != EOF)
+        reject(reason, "has data after the inputs");
+    else
+        ok = true;
+    fclose(file);
+    replay->overflow = false;
+    return ok;
+}
+
+// Whether `points` and `dynamites` are one of the outcomes of catching `kind`.
+static bool isOutcome(ObjectKind kind, int points, int dynamites) {
+    const ObjectArchetype* a = &OBJECT_ARCHETYPES[kind];
+    for (int i = 0; i < a->numOutcomes; i++) {
+        if (a->outcomes[i].points == points && a->outcomes[i].dynamites == dynamites)
+            return true;
+    }
+    return false;
+}
+
+// The rules one tick must have kept: the timer stands at the tick, a
+// player's score and dynamites only go up by a catch's outcome at the end
+// of a pull, and a dynamite is only spent on something being pulled.
+static bool checkRules(const Game* game, const PlayerState* before, char* reason) {
+    Uint32 tick = game->tick - 1;
+    float timeLeft = game->timeUp ? 0.0f : game->tuning->timeLimit - game->tick * SIM_DT;
+    if (game->timeLeft != timeLeft)
+        return reject(reason, "the timer stood at %.2f s after tick %u", game->timeLeft, tick);
+    for (int i = 0; i < game->numPlayers; i++) {
+        const PlayerState* was = &before[i];
+        const PlayerState* p = &game->players[i];
+        bool pulling = was->hookState == PULLING_GOLD && was->carrying;
+        int points = p->score - was->score, dynamites = p->dynamites - was->dynamites;
+        if (dynamites < 0 && !(dynamites == -1 && pulling && points == 0))
+            return reject(reason, "player %d's dynamites went from %d to %d at tick %u", i, was->dynamites,
+                          p->dynamites, tick);
+        if ((points != 0 || dynamites > 0) && !(pulling && !p->carrying && isOutcome(was->carriedKind, points, dynamites)))
+            return reject(reason, "player %d got %d points and %d dynamites at tick %u without such a catch", i,
+                          points, dynamites, tick);
+    }
+    return true;
+}
+
+static bool playBack(const Replay* replay, Game* game, char* reason) {
+    const ReplayHeader* h = &replay->header;
+    Uint32 next = 0;
+    while (!game->timeUp) {
+        Uint32 first = next;
+        for (; next < h->numInputs && replay->inputs[next].tick == game->tick; next++) {
+            const InputAction* input = &replay->inputs[next];
+            if (input->kind > INPUT_DYNAMITE || input->player >= h->numPlayers)
+                return reject(reason, "input %u is not a command for a player in the round", next);
+        }
+        if (next < h->numInputs && replay->inputs[next].tick < game->tick)
+            return reject(reason, "input %u is out of order", next);
+        if (next - first > MAX_TICK_INPUTS)
+            return reject(reason, "%u inputs in tick %u", next - first, game->tick);
+        PlayerState before[MAX_PLAYERS];
+        memcpy(before, game->players, sizeof(PlayerState) * game->numPlayers);
+        stepGame(game, replay->inputs + first, (int)(next - first));
+        if (!checkRules(game, before, reason))
+            return false;
+    }
+    if (next != h->numInputs)
+        return reject(reason, "%u inputs after the round ended", h->numInputs - next);
+    const PlayerState* p = &game->players[h->player];
+    if (game->tick != h->ticks)
+        return reject(reason, "claims %u ticks; the round ran %u", h->ticks, game->tick);
+    if (p->score != h->score)
+        return reject(reason, "claims %d points; the inputs make %d", h->score, p->score);
+    if (p->dynamites != h->dynamites)
+        return reject(reason, "claims %d dynamites left; the inputs leave %d", h->dynamites, p->dynamites);
+    return true;
+}
+
+bool verifyReplay(const Replay* replay, Level* level, Arena* arena, char* reason) {
+    const ReplayHeader* h = &replay->header;
+    if (h->numPlayers < 1 || h->numPlayers > MAX_PLAYERS || h->player >= h->numPlayers)
+        return reject(reason, "player %d of %d", h->player, h->numPlayers);
+    if (h->rewinds > 0)
+        return reject(reason, "went back in time %u times", h->rewinds);
+    if (hashLevel(level) != h->levelHash)
+        return reject(reason, "recorded on a different level %u", h->levelIndex);
+    // The timer is checked up front too, so that a bad claim costs nothing.
+    Uint32 length = (Uint32)(level->header->timeLimit * SIM_RATE + 0.5f);
+    if (h->ticks != length)
+        return reject(reason, "claims %u ticks; the level lasts %u", h->ticks, length);
+    Mine mine;
+    if (!initMine(&mine, level, arena))
+        return reject(reason, "out of memory");
+    Game game;
+    initGame(&game, level->header, &mine, h->numPlayers, h->seed);
+    bool ok = playBack(replay, &game, reason);
+    freeMine(&mine);
+    return ok;
+}
@@ -0,0 +1,81 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "game.h"
+#include "level.h"
+
+// A round's inputs, kept so that its score can be proven afterwards. The
+// simulation is deterministic, so the level, the seed and every command
+// that reached stepGame are enough to play the round again exactly;
+// tools/replaycheck.cpp does that for a batch of files and compares the
+// result with what the file claims.
+//
+// A file is a ReplayHeader followed by numInputs InputActions in tick
+// order. Going back in time takes the undone ticks' inputs out again, so a
+// file always holds one straight run from tick 0 to the end; the header
+// counts the rewinds, and a round that had any does not verify, as the
+// attempts it undid are gone.
+
+#define REPLAY_MAGIC 0x50524744u      // "DGRP"
+#define REPLAY_VERSION 2
+#define REPLAY_MAX_INPUTS 8192
+#define REPLAY_MAX_LEVEL 999          // Highest level index a replay can name.
+#define REPLAY_REASON_LEN 96
+
+typedef struct {
+    Uint32 magic;
+    Uint16 version;
+    Uint16 inputSize;         // sizeof(InputAction), in case its layout changes.
+    Uint32 levelIndex;        // As numbered for findLevelFile; generated past the last.
+    Uint32 levelHash;         // Of the level's tuning and objects.
+    Uint32 seed;
+    Uint8 numPlayers;
+    Uint8 player;             // Whose result is claimed.
+    Uint16 rewinds;           // Times the round went back.
+    // The claim: the round's length in ticks and the player's result.
+    Uint32 ticks;
+    Sint32 score;
+    Sint32 dynamites;
+    Uint32 numInputs;
+} ReplayHeader;
+
+typedef struct {
+    ReplayHeader header;
+    bool overflow;            // More inputs than fit; the round cannot be saved.
+    InputAction inputs[REPLAY_MAX_INPUTS];
+} Replay;
+
+// Starts recording a round of `level`.
+void beginReplay(Replay* replay, int levelIndex, const Level* level, Uint32 seed, int numPlayers, int player);
+
+// Adds the inputs of one tick, as passed to stepGame.
+void recordReplayInputs(Replay* replay, const InputAction* inputs, int numInputs);
+
+// The round went back to `tick`: drops the inputs from it on and counts
+// the rewind.
+void rewindReplay(Replay* replay, Uint32 tick);
+
+// Writes the replay with the finished round's result as the claim. A round
+// that went back in time or is past REPLAY_MAX_LEVEL is not saved, as it
+// could not be verified.
+bool saveReplay(const char* path, Replay* replay, const Game* game);
+
+// Reads a replay and checks that it is whole; says why not in `reason`.
+bool loadReplay(const char* path, Replay* replay, char* reason);
+
+// Plays the round again on `level`, which must be freshly loaded and is
+// sorted by the mine as in the game. True if the result matches the claim;
+// if not, says why in `reason`. The mine goes in `arena`.
+//
+// The claim check at the end is what proves a score: the inputs cannot
+// make the simulation break its rules. Along the way every tick is also
+// held to those rules (the timer runs down by the tick, points and
+// dynamites come only from a catch or a blast in the way the object's
+// outcomes allow), which catches a simulation that has drifted from them.
+bool verifyReplay(const Replay* replay, Level* level, Arena* arena, char* reason);
+
+#endif // REPLAY_H
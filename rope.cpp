@@ -0,0 +1,170 @@
+#include "rope.h"
+#include <math.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ROPE_HAS_SSE2
+#endif
+
+// Below this a segment has no direction to pull along.
+#define ROPE_MIN_LENGTH 0.001f
+
+static void pinEnds(Rope* rope, float fromX, float fromY, float toX, float toY) {
+    rope->x[0] = fromX;
+    rope->y[0] = fromY;
+    rope->x[ROPE_POINTS - 1] = toX;
+    rope->y[ROPE_POINTS - 1] = toY;
+}
+
+void resetRope(Rope* rope, float fromX, float fromY, float toX, float toY) {
+    memset(rope, 0, sizeof(Rope));
+    for (int i = 0; i < ROPE_POINTS; i++) {
+        float t = (float)i / (ROPE_POINTS - 1);
+        rope->x[i] = rope->oldX[i] = fromX + (toX - fromX) * t;
+        rope->y[i] = rope->oldY[i] = fromY + (toY - fromY) * t;
+    }
+}
+
+#ifdef ROPE_HAS_SSE2
+// x += (x - old) * damping, old = the x before, and gravity on y.
+static void integrateRope(Rope* rope, float fall) {
+    const __m128 damping = _mm_set1_ps(ROPE_DAMPING);
+    const __m128 down = _mm_set1_ps(fall);
+    for (int i = 0; i < ROPE_POINTS; i += 4) {
+        __m128 x = _mm_load_ps(rope->x + i), y = _mm_load_ps(rope->y + i);
+        __m128 vx = _mm_mul_ps(_mm_sub_ps(x, _mm_load_ps(rope->oldX + i)), damping);
+        __m128 vy = _mm_mul_ps(_mm_sub_ps(y, _mm_load_ps(rope->oldY + i)), damping);
+        _mm_store_ps(rope->oldX + i, x);
+        _mm_store_ps(rope->oldY + i, y);
+        _mm_store_ps(rope->x + i, _mm_add_ps(x, vx));
+        _mm_store_ps(rope->y + i, _mm_add_ps(_mm_add_ps(y, vy), down));
+    }
+}
+
+// Every segment pulls its two points half the way to its rest length,
+// all from the same positions, so the segments can go four at a time.
+static void relaxRope(Rope* rope, float rest) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 restLength = _mm_set1_ps(rest);
+    const __m128 minLength = _mm_set1_ps(ROPE_MIN_LENGTH);
+    for (int i = 0; i < ROPE_POINTS; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(rope->x + i + 1), _mm_load_ps(rope->x + i));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(rope->y + i + 1), _mm_load_ps(rope->y + i));
+        __m128 d = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))), minLength);
+        __m128 f = _mm_div_ps(_mm_mul_ps(_mm_sub_ps(d, restLength), half), d);
+        _mm_storeu_ps(rope->pullX + i + 1, _mm_mul_ps(dx, f));
+        _mm_storeu_ps(rope->pullY + i + 1, _mm_mul_ps(dy, f));
+    }
+    rope->pullX[ROPE_POINTS] = rope->pullY[ROPE_POINTS] = 0.0f; // Past the last point
+    for (int i = 0; i < ROPE_POINTS; i += 4) {
+        __m128 px = _mm_sub_ps(_mm_loadu_ps(rope->pullX + i + 1), _mm_load_ps(rope->pullX + i));
+        __m128 py = _mm_sub_ps(_mm_loadu_ps(rope->pullY + i + 1), _mm_load_ps(rope->pullY + i));
+        _mm_store_ps(rope->x + i, _mm_add_ps(_mm_load_ps(rope->x + i), px));
+        _mm_store_ps(rope->y + i, _mm_add_ps(_mm_load_ps(rope->y + i), py));
+    }
+}
+
+// Pulls every point that has got further from (endX, endY) than the rope
+// between them could reach straight back onto that circle. `first` is how
+// many segments lie between the end and point 0, and `step` the change for
+// each point after it.
+static void tetherRope(Rope* rope, float endX, float endY, float rest, float first, float step) {
+    const __m128 ex = _mm_set1_ps(endX), ey = _mm_set1_ps(endY);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minLength = _mm_set1_ps(ROPE_MIN_LENGTH);
+    const __m128 groupStep = _mm_set1_ps(4.0f * step * rest);
+    __m128 reach = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(first), _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step))),
+                              _mm_set1_ps(rest));
+    for (int i = 0; i < ROPE_POINTS; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(rope->x + i), ex);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(rope->y + i), ey);
+        __m128 d = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))), minLength);
+        __m128 scale = _mm_min_ps(_mm_div_ps(reach, d), one);
+        _mm_store_ps(rope->x + i, _mm_add_ps(ex, _mm_mul_ps(dx, scale)));
+        _mm_store_ps(rope->y + i, _mm_add_ps(ey, _mm_mul_ps(dy, scale)));
+        reach = _mm_add_ps(reach, groupStep);
+    }
+}
+#else
+static void integrateRope(Rope* rope, float fall) {
+    for (int i = 0; i < ROPE_POINTS; i++) {
+        float x = rope->x[i], y = rope->y[i];
+        rope->x[i] += (x - rope->oldX[i]) * ROPE_DAMPING;
+        rope->y[i] += (y - rope->oldY[i]) * ROPE_DAMPING + fall;
+        rope->oldX[i] = x;
+        rope->oldY[i] = y;
+    }
+}
+
+static void relaxRope(Rope* rope, float rest) {
+    for (int i = 0; i < ROPE_POINTS - 1; i++) {
+        float dx = rope->x[i + 1] - rope->x[i], dy = rope->y[i + 1] - rope->y[i];
+        float d = fmaxf(sqrtf(dx * dx + dy * dy), ROPE_MIN_LENGTH);
+        float f = (d - rest) * 0.5f / d;
+        rope->pullX[i + 1] = dx * f;
+        rope->pullY[i + 1] = dy * f;
+    }
+    rope->pullX[ROPE_POINTS] = rope->pullY[ROPE_POINTS] = 0.0f;
+    for (int i = 0; i < ROPE_POINTS; i++) {
+        rope->x[i] += rope->pullX[i + 1] - rope->pullX[i];
+        rope->y[i] += rope->pullY[i + 1] - rope->pullY[i];
+    }
+}
+
+static void tetherRope(Rope* rope, float endX, float endY, float rest, float first, float step) {
+    for (int i = 0; i < ROPE_POINTS; i++) {
+        float dx = rope->x[i] - endX, dy = rope->y[i] - endY;
+        float d = fmaxf(sqrtf(dx * dx + dy * dy), ROPE_MIN_LENGTH);
+        float scale = fminf((first + i * step) * rest / d, 1.0f);
+        rope->x[i] = endX + dx * scale;
+        rope->y[i] = endY + dy * scale;
+    }
+}
+#endif
+
+void stepRope(Rope* rope, float fromX, float fromY, float toX, float toY, float slack, float dt) {
+    integrateRope(rope, ROPE_GRAVITY * dt * dt);
+    float rest = hypotf(toX - fromX, toY - fromY) * slack / (ROPE_POINTS - 1);
+    // The segments alone only pass a pull along one point per pass, far
+    // too slowly to hold a long rope up; tethering every point to both
+    // ends keeps it from stretching whatever the number of passes.
+    for (int n = 0; n < ROPE_ITERATIONS; n++) {
+        pinEnds(rope, fromX, fromY, toX, toY);
+        relaxRope(rope, rest);
+        tetherRope(rope, fromX, fromY, rest, 0.0f, 1.0f);
+        tetherRope(rope, toX, toY, rest, ROPE_POINTS - 1, -1.0f);
+    }
+    pinEnds(rope, fromX, fromY, toX, toY);
+}
+
+void copyRopePoints(const Rope* rope, RopePoints* points) {
+    memcpy(points->x, rope->x, sizeof(points->x));
+    memcpy(points->y, rope->y, sizeof(points->y));
+}
+
+void drawRope(const RopePoints* points, SDL_Renderer* renderer, float cameraY, SDL_Color color) {
+    SDL_Vertex vertices[2 * ROPE_POINTS];
+    int indices[6 * (ROPE_POINTS - 1)];
+    // Each point becomes a pair of vertices across the rope, square to the
+    // line through its neighbours.
+    for (int i = 0; i < ROPE_POINTS; i++) {
+        int a = i > 0 ? i - 1 : 0, b = i < ROPE_POINTS - 1 ? i + 1 : i;
+        float tx = points->x[b] - points->x[a], ty = points->y[b] - points->y[a];
+        float length = sqrtf(tx * tx + ty * ty);
+        float scale = length > ROPE_MIN_LENGTH ? ROPE_HALF_WIDTH / length : 0.0f;
+        float nx = -ty * scale, ny = tx * scale;
+        float x = points->x[i], y = points->y[i] - cameraY;
+        vertices[2 * i] = (SDL_Vertex){{x + nx, y + ny}, color, {0.0f, 0.0f}};
+        vertices[2 * i + 1] = (SDL_Vertex){{x - nx, y - ny}, color, {0.0f, 0.0f}};
+    }
+    for (int i = 0; i < ROPE_POINTS - 1; i++) {
+        int* q = indices + 6 * i;
+        q[0] = 2 * i;
+        q[1] = 2 * i + 1;
+        q[2] = 2 * i + 2;
+        q[3] = 2 * i + 1;
+        q[4] = 2 * i + 3;
+        q[5] = 2 * i + 2;
+    }
+    SDL_RenderGeometry(renderer, NULL, vertices, 2 * ROPE_POINTS, indices, 6 * (ROPE_POINTS - 1));
+}
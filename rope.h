@@ -0,0 +1,53 @@
+#ifndef ROPE_H
+#define ROPE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// The rope between a character and its hook, as a chain of points moved by
+// Verlet integration and held together by distance constraints. Its ends
+// are pinned to the anchor and the hook, which the game moves on its own;
+// the points in between swing, sag and lag behind them. The positions are
+// kept one array per coordinate and stepped four points at a time.
+//
+// Like the particles, the rope is only decoration: it is not part of the
+// game state and does not need to match between players.
+
+#define ROPE_POINTS 32            // Ends included; a multiple of four.
+#define ROPE_ITERATIONS 8         // Constraint passes per step.
+#define ROPE_GRAVITY 1500.0f      // px/s^2
+#define ROPE_DAMPING 0.98f        // Share of its speed a point keeps per step.
+#define ROPE_SLACK 1.02f          // Rope length over the distance between its ends.
+#define ROPE_LOAD_SLACK 0.10f     // Added at zero retract speed, in proportion below full speed.
+#define ROPE_HALF_WIDTH 1.0f      // Drawn this far either side of the points.
+
+// The points as published for drawing, in mine coordinates.
+typedef struct {
+    float x[ROPE_POINTS];
+    float y[ROPE_POINTS];
+} RopePoints;
+
+// One spare slot past the last point lets the loops read and write a whole
+// group of four at the end.
+typedef struct {
+    alignas(16) float x[ROPE_POINTS + 4];
+    alignas(16) float y[ROPE_POINTS + 4];
+    alignas(16) float oldX[ROPE_POINTS + 4];  // Last step's, for the velocity.
+    alignas(16) float oldY[ROPE_POINTS + 4];
+    alignas(16) float pullX[ROPE_POINTS + 4];  // Scratch: segment i's pull is at i + 1.
+    alignas(16) float pullY[ROPE_POINTS + 4];
+} Rope;
+
+// Lays the rope out straight and still from (fromX, fromY) to (toX, toY).
+void resetRope(Rope* rope, float fromX, float fromY, float toX, float toY);
+
+// Moves the ends to their new places and the rest of the rope on by dt.
+// `slack` is the rope's length over the distance between the ends.
+void stepRope(Rope* rope, float fromX, float fromY, float toX, float toY, float slack, float dt);
+
+void copyRopePoints(const Rope* rope, RopePoints* points);
+
+// Draws the rope as one triangle strip, shifted up by cameraY.
+void drawRope(const RopePoints* points, SDL_Renderer* renderer, float cameraY, SDL_Color color);
+
+#endif // ROPE_H
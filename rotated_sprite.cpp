@@ -0,0 +1,175 @@
+#include "rotated_sprite.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc_track.h"
+
+#define PI 3.14159265358979323846
+
+// Shrinks `source` to w x h by averaging every source pixel into the one it
+// lands on. Colours are premultiplied by alpha, so transparent pixels do not
+// darken the edges.
+static void shrinkPremultiplied(SDL_Surface* source, int w, int h, float* out) {
+    float* weight = (float*)calloc((size_t)w * h, sizeof(float));
+    memset(out, 0, (size_t)w * h * 4 * sizeof(float));
+    for (int sy = 0; sy < source->h; sy++) {
+        const Uint32* row = (const Uint32*)((const Uint8*)source->pixels + sy * source->pitch);
+        int y = sy * h / source->h;
+        for (int sx = 0; sx < source->w; sx++) {
+            int x = sx * w / source->w;
+            Uint32 p = row[sx];
+            float a = (p >> 24) / 255.0f;
+            float* o = &out[(y * w + x) * 4];
+            o[0] += ((p >> 16) & 0xFF) * a;
+            o[1] += ((p >> 8) & 0xFF) * a;
+            o[2] += (p & 0xFF) * a;
+            o[3] += a;
+            weight[y * w + x] += 1.0f;
+        }
+    }
+    for (int i = 0; i < w * h; i++) {
+        for (int c = 0; c < 4 && weight[i] > 0.0f; c++)
+            out[i * 4 + c] /= weight[i];
+    }
+    free(weight);
+}
+
+// Bilinear sample at (x, y) in pixel units; beyond the image is clear.
+static void samplePremultiplied(const float* image, int w, int h, float x, float y, float* out) {
+    int x0 = (int)floorf(x), y0 = (int)floorf(y);
+    float fx = x - x0, fy = y - y0;
+    memset(out, 0, 4 * sizeof(float));
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            int px = x0 + i, py = y0 + j;
+            if (px < 0 || py < 0 || px >= w || py >= h)
+                continue;
+            float k = (i ? fx : 1.0f - fx) * (j ? fy : 1.0f - fy);
+            for (int c = 0; c < 4; c++)
+                out[c] += image[(py * w + px) * 4 + c] * k;
+        }
+    }
+}
+
+static float frameAngle(int frame) {
+    return -ROTATED_MAX_DEG + frame * ROTATED_STEP_DEG;
+}
+
+bool buildRotatedSprite(RotatedSprite* sprite, SDL_Surface* source, int w, int h, SDL_Point pivot) {
+    memset(sprite, 0, sizeof(RotatedSprite));
+    if (!source)
+        return false;
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!argb) {
+        printf("Error converting sprite: %s\n", SDL_GetError());
+        return false;
+    }
+    float* image = (float*)malloc((size_t)w * h * 4 * sizeof(float));
+    shrinkPremultiplied(argb, w, h, image);
+    SDL_FreeSurface(argb);
+    // Each frame is the box round the turned rect. Lay them out in rows
+    // first to know how tall the sheet is.
+    float cornersX[4] = {-(float)pivot.x, (float)(w - pivot.x), (float)(w - pivot.x), -(float)pivot.x};
+    float cornersY[4] = {-(float)pivot.y, -(float)pivot.y, (float)(h - pivot.y), (float)(h - pivot.y)};
+    int x = 0, y = 0, rowHeight = 0;
+    for (int f = 0; f < ROTATED_FRAMES; f++) {
+        double a = frameAngle(f) * PI / 180.0;
+        float c = (float)cos(a), s = (float)sin(a);
+        float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+        for (int i = 0; i < 4; i++) {
+            // Clockwise on screen, as SDL_RenderCopyEx turns.
+            float rx = cornersX[i] * c - cornersY[i] * s;
+            float ry = cornersX[i] * s + cornersY[i] * c;
+            minX = fminf(minX, rx);
+            maxX = fmaxf(maxX, rx);
+            minY = fminf(minY, ry);
+            maxY = fmaxf(maxY, ry);
+        }
+        RotatedFrame* frame = &sprite->frames[f];
+        frame->offset = (SDL_Point){(int)floorf(minX), (int)floorf(minY)};
+        frame->src.w = (int)ceilf(maxX) - frame->offset.x;
+        frame->src.h = (int)ceilf(maxY) - frame->offset.y;
+        if (x + frame->src.w > ROTATED_SHEET_WIDTH) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        frame->src.x = x;
+        frame->src.y = y;
+        x += frame->src.w;
+        if (frame->src.h > rowHeight)
+            rowHeight = frame->src.h;
+    }
+    sprite->sheet = trackedCreateSurface(ROTATED_SHEET_WIDTH, y + rowHeight);
+    if (!sprite->sheet) {
+        printf("Error creating sprite sheet: %s\n", SDL_GetError());
+        free(image);
+        return false;
+    }
+    for (int f = 0; f < ROTATED_FRAMES; f++) {
+        const RotatedFrame* frame = &sprite->frames[f];
+        double a = frameAngle(f) * PI / 180.0;
+        float c = (float)cos(a), s = (float)sin(a);
+        for (int oy = 0; oy < frame->src.h; oy++) {
+            Uint32* row = (Uint32*)((Uint8*)sprite->sheet->pixels + (frame->src.y + oy) * sprite->sheet->pitch) + frame->src.x;
+            for (int ox = 0; ox < frame->src.w; ox++) {
+                // Turn the pixel's centre back to find where it came from.
+                float qx = frame->offset.x + ox + 0.5f;
+                float qy = frame->offset.y + oy + 0.5f;
+                float sx = pivot.x + qx * c + qy * s;
+                float sy = pivot.y - qx * s + qy * c;
+                float p[4];
+                samplePremultiplied(image, w, h, sx - 0.5f, sy - 0.5f, p);
+                Uint32 alpha = (Uint32)(p[3] * 255.0f + 0.5f);
+                Uint32 rgb = 0;
+                if (p[3] > 0.0f) {
+                    for (int i = 0; i < 3; i++) {
+                        float v = p[i] / p[3];
+                        rgb = rgb << 8 | (Uint32)(v > 255.0f ? 255.0f : v + 0.5f);
+                    }
+                }
+                row[ox] = (alpha > 255 ? 255 : alpha) << 24 | rgb;
+            }
+        }
+    }
+    free(image);
+    return true;
+}
+
+bool uploadRotatedSprite(RotatedSprite* sprite, SDL_Renderer* renderer) {
+    if (!sprite->sheet)
+        return false;
+    sprite->texture = trackedCreateTextureFromSurface(renderer, sprite->sheet);
+    trackedFreeSurface(sprite->sheet);
+    sprite->sheet = NULL;
+    if (!sprite->texture) {
+        printf("Error creating sprite texture: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(sprite->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+const RotatedFrame* findRotatedFrame(const RotatedSprite* sprite, float angleDeg) {
+    if (angleDeg < -ROTATED_MAX_DEG || angleDeg > ROTATED_MAX_DEG)
+        return NULL;
+    return &sprite->frames[(int)((angleDeg + ROTATED_MAX_DEG) / ROTATED_STEP_DEG + 0.5f)];
+}
+
+bool drawRotatedSprite(const RotatedSprite* sprite, SDL_Renderer* renderer, const SDL_Rect* dst, SDL_Point pivot,
+                       float angleDeg) {
+    const RotatedFrame* frame = findRotatedFrame(sprite, angleDeg);
+    if (!sprite->texture || !frame)
+        return false;
+    SDL_Rect r = {dst->x + pivot.x + frame->offset.x, dst->y + pivot.y + frame->offset.y, frame->src.w, frame->src.h};
+    SDL_RenderCopy(renderer, sprite->texture, &frame->src, &r);
+    return true;
+}
+
+void freeRotatedSprite(RotatedSprite* sprite) {
+    trackedFreeSurface(sprite->sheet);
+    trackedDestroyTexture(sprite->texture);
+    sprite->sheet = NULL;
+    sprite->texture = NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef ROTATED_SPRITE_H
+#define ROTATED_SPRITE_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+// A sprite shrunk to its on-screen size and turned about a pivot at every
+// ROTATED_STEP_DEG across +-ROTATED_MAX_DEG, all in one sheet. Drawing it
+// at an angle is then a plain unscaled copy of the nearest frame, where
+// SDL_RenderCopyEx would scale and rotate the full-size source every frame
+// (slow on the software renderer).
+#define ROTATED_STEP_DEG 0.5f
+#define ROTATED_MAX_DEG 90.0f
+#define ROTATED_FRAMES 361
+#define ROTATED_SHEET_WIDTH 1024
+
+typedef struct {
+    SDL_Rect src;             // In the sheet.
+    SDL_Point offset;         // Top-left corner relative to the pivot.
+} RotatedFrame;
+
+typedef struct {
+    SDL_Surface* sheet;       // Until uploaded.
+    SDL_Texture* texture;
+    RotatedFrame frames[ROTATED_FRAMES];
+} RotatedSprite;
+
+// Renders the frames into a sheet surface: `source` stretched to w x h and
+// turned about `pivot` (relative to that rect). Touches no renderer, so it
+// can run on a loader thread.
+bool buildRotatedSprite(RotatedSprite* sprite, SDL_Surface* source, int w, int h, SDL_Point pivot);
+
+// The frame nearest to `angleDeg`, or NULL outside the range.
+const RotatedFrame* findRotatedFrame(const RotatedSprite* sprite, float angleDeg);
+
+// Turns the sheet into a texture. Main thread only.
+bool uploadRotatedSprite(RotatedSprite* sprite, SDL_Renderer* renderer);
+
+// Draws the frame nearest to what SDL_RenderCopyEx(renderer, source, NULL,
+// dst, angleDeg, &pivot, SDL_FLIP_NONE) would draw. Returns false, drawing
+// nothing, when the angle is outside the frames or the sprite is not
+// uploaded.
+bool drawRotatedSprite(const RotatedSprite* sprite, SDL_Renderer* renderer, const SDL_Rect* dst, SDL_Point pivot,
+                       float angleDeg);
+
+void freeRotatedSprite(RotatedSprite* sprite);
+
+#endif // ROTATED_SPRITE_H
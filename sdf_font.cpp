@@ -0,0 +1,89 @@
+#include "sdf_font.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t sdfBlockSize(int width, int height) {
+    return sizeof(SdfHeader) + (size_t)width * (size_t)height;
+}
+
+static void bindSdfFont(SdfFont* font, void* block, size_t blockSize) {
+    font->block = block;
+    font->blockSize = blockSize;
+    font->header = (SdfHeader*)block;
+    font->pixels = (Uint8*)block + sizeof(SdfHeader);
+}
+
+bool allocSdfFont(SdfFont* font, int width, int height) {
+    size_t size = sdfBlockSize(width, height);
+    void* block = calloc(1, size);
+    if (block == NULL)
+        return false;
+    bindSdfFont(font, block, size);
+    font->header->magic = SDF_MAGIC;
+    font->header->version = SDF_VERSION;
+    font->header->fileSize = (Uint32)size;
+    font->header->atlasWidth = width;
+    font->header->atlasHeight = height;
+    return true;
+}
+
+// Every cell has to lie inside the atlas, or drawing would read past it.
+static bool glyphsValid(const SdfHeader* header) {
+    for (int i = 0; i < SDF_NUM_CHARS; i++) {
+        const SdfGlyph* g = &header->glyphs[i];
+        if (g->w < 0 || g->h < 0 || g->x < 0 || g->y < 0 || g->x + g->w > header->atlasWidth ||
+            g->y + g->h > header->atlasHeight)
+            return false;
+    }
+    return true;
+}
+
+bool loadSdfFont(const char* path, SdfFont* font) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error opening font %s (build it with fontbake)\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < (long)sizeof(SdfHeader)) {
+        printf("Font %s is truncated\n", path);
+        fclose(file);
+        return false;
+    }
+    void* block = malloc((size_t)size);
+    if (block == NULL) {
+        fclose(file);
+        return false;
+    }
+    size_t got = fread(block, 1, (size_t)size, file);
+    fclose(file);
+    const SdfHeader* header = (const SdfHeader*)block;
+    if (got != (size_t)size || header->magic != SDF_MAGIC || header->version != SDF_VERSION ||
+        header->fileSize != (Uint32)size || header->atlasWidth <= 0 || header->atlasHeight <= 0 ||
+        sdfBlockSize(header->atlasWidth, header->atlasHeight) != (size_t)size || !glyphsValid(header)) {
+        printf("Font %s is not a valid baked font (rebuild it with fontbake)\n", path);
+        free(block);
+        return false;
+    }
+    bindSdfFont(font, block, (size_t)size);
+    return true;
+}
+
+bool saveSdfFont(const char* path, const SdfFont* font) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        printf("Error writing font %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(font->block, 1, font->blockSize, file) == font->blockSize;
+    fclose(file);
+    return ok;
+}
+
+void freeSdfFont(SdfFont* font) {
+    free(font->block);
+    memset(font, 0, sizeof(SdfFont));
+}
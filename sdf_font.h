@@ -0,0 +1,57 @@
+#ifndef SDF_FONT_H
+#define SDF_FONT_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// A font baked offline (tools/fontbake.cpp) into one signed distance field
+// atlas, so the game draws text at any size without FreeType. Each texel
+// holds the distance to the nearest glyph edge: 128 is on the edge, higher
+// is inside, and 0 or 255 is SDF_SPREAD pixels or more away.
+
+// Baked font files start with this magic ("DSDF") and version.
+#define SDF_MAGIC 0x46445344u
+#define SDF_VERSION 1
+#define SDF_FIRST_CHAR 32
+#define SDF_NUM_CHARS 95          // Printable ASCII.
+#define SDF_BAKE_SIZE 32          // Point size the field is baked at.
+#define SDF_SPREAD 4              // Distance range each side of the edge, and the padding round each glyph.
+#define SDF_ATLAS_WIDTH 512
+
+typedef struct {
+    int x, y, w, h;               // Cell in the atlas, padding included. w is 0 for a glyph the font lacks.
+    float advance;                // Pen advance at SDF_BAKE_SIZE.
+} SdfGlyph;
+
+// Also the header of the baked file, which is followed directly by the
+// atlas, one byte per texel, so it must stay a plain fixed-size struct.
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 fileSize;
+    float lineHeight;             // At SDF_BAKE_SIZE; cells are this tall plus padding.
+    int atlasWidth;
+    int atlasHeight;
+    SdfGlyph glyphs[SDF_NUM_CHARS];
+} SdfHeader;
+
+// A loaded font. header and pixels point into one block.
+typedef struct {
+    SdfHeader* header;
+    Uint8* pixels;
+    void* block;
+    size_t blockSize;
+} SdfFont;
+
+// Allocates a font with an atlas of the given size, for the baker to fill.
+bool allocSdfFont(SdfFont* font, int width, int height);
+
+// Loads a baked font with a single read into a single allocation.
+bool loadSdfFont(const char* path, SdfFont* font);
+
+bool saveSdfFont(const char* path, const SdfFont* font);
+
+void freeSdfFont(SdfFont* font);
+
+#endif // SDF_FONT_H
@@ -0,0 +1,81 @@
+#include "sequence.h"
+#include <cstddef>
+#include <new>
+#include <stdio.h>
+
+// Coroutine frames are carved from a fixed pool. Only a handful of
+// sequences (the current screen and an effect or two) are ever alive at
+// once, and all of them run on the main thread.
+#define SEQUENCE_POOL_SLOTS 8
+#define SEQUENCE_SLOT_SIZE 1024
+
+alignas(std::max_align_t) static unsigned char sequencePool[SEQUENCE_POOL_SLOTS][SEQUENCE_SLOT_SIZE];
+static bool sequenceSlotUsed[SEQUENCE_POOL_SLOTS];
+
+void* Sequence::promise_type::operator new(size_t size) {
+    if (size <= SEQUENCE_SLOT_SIZE) {
+        for (int i = 0; i < SEQUENCE_POOL_SLOTS; i++) {
+            if (!sequenceSlotUsed[i]) {
+                sequenceSlotUsed[i] = true;
+                return sequencePool[i];
+            }
+        }
+    }
+    printf("Sequence pool exhausted (frame of %u bytes), using the heap\n", (unsigned)size);
+    return ::operator new(size);
+}
+
+void Sequence::promise_type::operator delete(void* ptr, size_t size) {
+    unsigned char* p = (unsigned char*)ptr;
+    if (p >= &sequencePool[0][0] && p < &sequencePool[0][0] + sizeof(sequencePool)) {
+        sequenceSlotUsed[(p - &sequencePool[0][0]) / SEQUENCE_SLOT_SIZE] = false;
+        return;
+    }
+    ::operator delete(ptr, size);
+}
+
+Sequence& Sequence::operator=(Sequence&& other) noexcept {
+    if (this != &other) {
+        if (handle)
+            handle.destroy();
+        handle = other.handle;
+        started = other.started;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+Sequence::~Sequence() {
+    if (handle)
+        handle.destroy();
+}
+
+// Runs the sequence to its next wait. An exception it did not catch has
+// ended it; passing it on keeps the failure from looking like a normal end.
+void Sequence::resume() {
+    handle.resume();
+    if (handle.promise().exception)
+        std::rethrow_exception(handle.promise().exception);
+}
+
+bool Sequence::tick(float deltaTime) {
+    if (done())
+        return false;
+    promise_type& promise = handle.promise();
+    promise.frameTime = deltaTime;
+    if (!started) {
+        // The frame the sequence starts on does not count against its first wait.
+        started = true;
+        resume();
+    } else if (promise.waitFrame) {
+        promise.waitFrame = false;
+        promise.waitRemaining = 0.0f;
+        resume();
+    } else {
+        promise.waitRemaining -= deltaTime;
+    }
+    // Run through every timed wait that has already elapsed.
+    while (!handle.done() && !promise.waitFrame && promise.waitRemaining <= 0.0f)
+        resume();
+    return !handle.done();
+}
@@ -0,0 +1,86 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include <coroutine>
+#include <exception>
+#include <stddef.h>
+
+// A timed sequence written as a coroutine and resumed once per frame from
+// the main loop, e.g.
+//
+//     Sequence blink() {
+//         showThing = true;
+//         co_await waitSeconds(0.5f);
+//         showThing = false;
+//     }
+//
+// Awaiting never allocates; the coroutine frame itself comes from a small
+// fixed pool (see sequence.cpp), so starting a sequence does not either.
+class Sequence {
+public:
+    struct promise_type {
+        float waitRemaining = 0.0f;   // Seconds left on the current wait.
+        bool waitFrame = false;       // Resume on the next tick regardless of time.
+        float frameTime = 0.0f;       // Delta time handed to nextFrame().
+        std::exception_ptr exception; // Thrown inside; tick() throws it on.
+
+        Sequence get_return_object() { return Sequence(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        // Nothing runs until the first tick, so a sequence can be created
+        // ahead of the frame that starts it.
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Sequence() = default;
+    explicit Sequence(Handle handle) : handle(handle) {}
+    Sequence(Sequence&& other) noexcept : handle(other.handle), started(other.started) { other.handle = nullptr; }
+    Sequence& operator=(Sequence&& other) noexcept;
+    Sequence(const Sequence&) = delete;
+    Sequence& operator=(const Sequence&) = delete;
+    ~Sequence();
+
+    // Advances the sequence by deltaTime seconds, resuming it as many times
+    // as its waits allow. Returns true while it is still running. An
+    // exception the sequence let out comes out of here.
+    bool tick(float deltaTime);
+    bool done() const { return !handle || handle.done(); }
+
+private:
+    Handle handle = nullptr;
+    bool started = false;
+
+    void resume();
+};
+
+// co_await waitSeconds(s): resume once s seconds of ticks have passed. Time
+// overshot by a long frame is carried into the next wait, so a chain of
+// waits stays in step with the clock whatever the frame rate.
+struct WaitSeconds {
+    float seconds;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Sequence::Handle handle) const noexcept { handle.promise().waitRemaining += seconds; }
+    void await_resume() const noexcept {}
+};
+
+inline WaitSeconds waitSeconds(float seconds) { return WaitSeconds{seconds}; }
+
+// float dt = co_await nextFrame(): resume on the next tick, with its delta time.
+struct NextFrame {
+    Sequence::promise_type* promise = nullptr;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Sequence::Handle handle) noexcept {
+        promise = &handle.promise();
+        promise->waitFrame = true;
+    }
+    float await_resume() const noexcept { return promise->frameTime; }
+};
+
+inline NextFrame nextFrame() { return NextFrame{}; }
+
+#endif // SEQUENCE_H
@@ -0,0 +1,152 @@
+#include "sfx.h"
+#include <SDL_mixer.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PI 3.14159265358979323846
+
+// A stand-in effect: a tone sliding from startHz to endHz, mixed with some
+// noise, under an exponential decay.
+typedef struct {
+    const char* file;
+    int priority;             // Higher steals from lower.
+    float startHz, endHz;
+    float noise;              // 0 = pure tone, 1 = pure noise.
+    float seconds;
+    float decay;              // Envelope falloff per second.
+} SfxInfo;
+
+static const SfxInfo SFX_INFO[NUM_SFX] = {
+    {"sounds/grab.wav",      1, 180.0f, 90.0f,   0.2f, 0.08f, 30.0f},
+    {"sounds/retract.wav",   0, 70.0f,  70.0f,   0.6f, 0.12f, 0.0f},
+    {"sounds/score.wav",     2, 660.0f, 990.0f,  0.0f, 0.25f, 10.0f},
+    {"sounds/dynamite.wav",  2, 300.0f, 500.0f,  0.8f, 0.20f, 6.0f},
+    {"sounds/explosion.wav", 3, 90.0f,  30.0f,   0.9f, 0.60f, 6.0f},
+};
+
+typedef struct {
+    SfxId id;
+    int priority;
+    Uint32 startTicks;
+} SfxVoice;
+
+static Mix_Chunk* chunks[NUM_SFX];
+static Uint8* synthBuffers[NUM_SFX];  // Sample data behind synthesized chunks.
+static SfxVoice voices[SFX_CHANNELS];
+
+bool openSfxAudio(int bufferFrames) {
+    if (bufferFrames <= 0)
+        bufferFrames = SFX_DEFAULT_BUFFER;
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, bufferFrames) < 0) {
+        printf("SDL_mixer could not initialize! Mix_Error: %s\n", Mix_GetError());
+        return false;
+    }
+    Mix_AllocateChannels(SFX_CHANNELS);
+    return true;
+}
+
+// Renders a stand-in effect as 16-bit samples in the mixer's output format.
+static Mix_Chunk* synthesizeSfx(SfxId id) {
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels) || format != AUDIO_S16SYS)
+        return NULL;
+    const SfxInfo* info = &SFX_INFO[id];
+    int frames = (int)(info->seconds * freq);
+    Sint16* samples = (Sint16*)malloc(sizeof(Sint16) * frames * channels);
+    if (samples == NULL)
+        return NULL;
+    Uint32 rng = 0x2545F491u + id;
+    float phase = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        float t = (float)i / freq;
+        float hz = info->startHz + (info->endHz - info->startHz) * t / info->seconds;
+        phase += hz / freq;
+        phase -= floorf(phase);
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        float noise = (rng >> 8) * (2.0f / 16777216.0f) - 1.0f;
+        float tone = sinf(phase * (float)(2 * PI));
+        // Short fades at both ends keep the start and a loop seam click-free.
+        float edge = fminf(1.0f, fminf(t, info->seconds - t) * 200.0f);
+        float v = (tone * (1.0f - info->noise) + noise * info->noise) * expf(-info->decay * t) * edge;
+        for (int c = 0; c < channels; c++)
+            samples[i * channels + c] = (Sint16)(v * 12000.0f);
+    }
+    Mix_Chunk* chunk = Mix_QuickLoad_RAW((Uint8*)samples, (Uint32)(sizeof(Sint16) * frames * channels));
+    if (chunk == NULL) {
+        free(samples);
+        return NULL;
+    }
+    synthBuffers[id] = (Uint8*)samples;
+    return chunk;
+}
+
+void loadSfx(void) {
+    for (int i = 0; i < NUM_SFX; i++) {
+        chunks[i] = Mix_LoadWAV(SFX_INFO[i].file);
+        if (chunks[i] == NULL)
+            chunks[i] = synthesizeSfx((SfxId)i);
+        if (chunks[i] == NULL)
+            printf("Error loading sound %s: %s\n", SFX_INFO[i].file, Mix_GetError());
+    }
+}
+
+// A free channel if there is one, otherwise the oldest one playing something
+// that matters no more than `priority`. -1 if every channel is busy with
+// something more important.
+static int pickChannel(int priority) {
+    int best = -1;
+    for (int ch = 0; ch < SFX_CHANNELS; ch++) {
+        if (!Mix_Playing(ch))
+            return ch;
+        const SfxVoice* v = &voices[ch];
+        if (v->priority > priority)
+            continue;
+        if (best == -1 || v->priority < voices[best].priority ||
+            (v->priority == voices[best].priority && v->startTicks < voices[best].startTicks))
+            best = ch;
+    }
+    return best;
+}
+
+int playSfx(SfxId id, bool loop) {
+    if (chunks[id] == NULL)
+        return -1;
+    int priority = SFX_INFO[id].priority;
+    int ch = pickChannel(priority);
+    if (ch == -1)
+        return -1;
+    // Mix_PlayChannel replaces whatever the channel was playing.
+    ch = Mix_PlayChannel(ch, chunks[id], loop ? -1 : 0);
+    if (ch == -1)
+        return -1;
+    voices[ch].id = id;
+    voices[ch].priority = priority;
+    voices[ch].startTicks = SDL_GetTicks();
+    return ch;
+}
+
+void stopSfx(SfxId id) {
+    for (int ch = 0; ch < SFX_CHANNELS; ch++) {
+        if (voices[ch].id == id && Mix_Playing(ch))
+            Mix_HaltChannel(ch);
+    }
+}
+
+void stopAllSfx(void) {
+    Mix_HaltChannel(-1);
+}
+
+void freeSfx(void) {
+    Mix_HaltChannel(-1);
+    for (int i = 0; i < NUM_SFX; i++) {
+        if (chunks[i] != NULL)
+            Mix_FreeChunk(chunks[i]);
+        free(synthBuffers[i]);
+        chunks[i] = NULL;
+        synthBuffers[i] = NULL;
+    }
+}
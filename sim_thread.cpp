@@ -0,0 +1,230 @@
+#include "sim_thread.h"
+#include <stdio.h>
+#include <string.h>
+#include "mine.h"
+#include "perf_counters.h"
+#include "telemetry.h"
+
+// Brings each rope's ends to its anchor and hook, and the rest of it on by
+// a tick, or with `reset`, lays it out straight between them.
+static void moveRopes(SimThread* sim, bool reset) {
+    const Game* game = sim->game;
+    for (int i = 0; i < game->numPlayers; i++) {
+        const PlayerState* p = &game->players[i];
+        SDL_Rect rect = hookRect(game, p);
+        float hookX = (float)(rect.x + game->hookPivot.x), hookY = (float)(rect.y + game->hookPivot.y);
+        if (reset) {
+            resetRope(&sim->ropes[i], p->anchorX, p->anchorY, hookX, hookY);
+            continue;
+        }
+        // A heavy load comes up slowly, on a slacker rope.
+        float slack = ROPE_SLACK;
+        if (p->hookState == PULLING_GOLD)
+            slack += ROPE_LOAD_SLACK * (1.0f - OBJECT_ARCHETYPES[p->carriedKind].retractScale);
+        stepRope(&sim->ropes[i], p->anchorX, p->anchorY, hookX, hookY, slack, SIM_DT);
+    }
+}
+
+// Fills the back view from the game and hands it to the main thread.
+static void publishView(SimThread* sim, int rewinds) {
+    const Game* game = sim->game;
+    FrameView* view = &sim->frames[sim->views.back];
+    view->tick = game->tick;
+    view->timeUp = game->timeUp;
+    view->timeLeft = game->timeLeft;
+    view->cameraY = hookViewTop(game, sim->localPlayer);
+    view->numPlayers = game->numPlayers;
+    for (int i = 0; i < game->numPlayers; i++) {
+        view->players[i] = game->players[i];
+        view->hookRects[i] = hookRect(game, &game->players[i]);
+    }
+    view->hookW = game->hookW;
+    view->hookH = game->hookH;
+    view->hookPivot = game->hookPivot;
+    view->rewinds = rewinds;
+    for (int i = 0; i < game->numPlayers; i++)
+        copyRopePoints(&sim->ropes[i], &view->ropes[i]);
+    // The level loader keeps what these chunks hold within FRAME_MAX_OBJECTS.
+    MineChunk* chunks[MINE_RESIDENT_CHUNKS];
+    int numChunks = findMineChunks(game->mine, view->cameraY, view->cameraY + VIEW_HEIGHT, chunks);
+    view->numObjects = 0;
+    for (int c = 0; c < numChunks; c++) {
+        const MineChunk* chunk = chunks[c];
+        for (int i = 0; i < chunk->numGolds && view->numObjects < FRAME_MAX_OBJECTS; i++) {
+            if (chunk->golds[i].active)
+                view->objects[view->numObjects++] = (FrameObject){chunk->golds[i].rect, chunk->golds[i].type};
+        }
+        for (int i = 0; i < chunk->numRocks && view->numObjects < FRAME_MAX_OBJECTS; i++) {
+            if (chunk->rocks[i].active)
+                view->objects[view->numObjects++] = (FrameObject){chunk->rocks[i].rect, chunk->rocks[i].type};
+        }
+    }
+    publishTripleBuffer(&sim->views);
+}
+
+static int simWorker(void* data) {
+    SimThread* sim = (SimThread*)data;
+    Game* game = sim->game;
+    NetSession* net = sim->net;
+    if (sim->perfCounters)
+        openPerfCounters();
+    InputAction pending[MAX_TICK_INPUTS]; // Local commands waiting for their tick
+    int numPending = 0;
+    int rewinds = 0;
+    Uint64 started = SDL_GetPerformanceCounter();
+    while (!game->timeUp && !sim->quit.load(std::memory_order_relaxed)) {
+        beginPerfPhase(PERF_EVENTS);
+        Uint64 wake = SDL_GetPerformanceCounter();
+        // A key press lands inputDelay ticks after the moment it was made,
+        // but never in a tick already simulated or already promised to the
+        // other player. The lag or the delay leaves it time to get here, so
+        // that only a press held up for longer is moved to the next open
+        // tick.
+        Uint32 firstOpen = game->tick;
+        if (sim->online && net->sentConfirmed > firstOpen)
+            firstOpen = net->sentConfirmed;
+        Uint32 tail = sim->queueTail.load(std::memory_order_relaxed);
+        Uint32 head = sim->queueHead.load(std::memory_order_acquire);
+        bool rewound = false;
+        for (; tail != head; tail++) {
+            const SimCommand* command = &sim->queue[tail & (SIM_QUEUE_SIZE - 1)];
+            if (command->rewind) {
+                Uint32 back = 5 * SIM_RATE;
+                if (rollbackGame(&sim->snapshots, game, game->tick > back ? game->tick - back : 0)) {
+                    sim->startTicks = SDL_GetTicks() - (game->tick + sim->lag) * 1000 / SIM_RATE;
+                    numPending = 0;
+                    firstOpen = game->tick;
+                    rewinds++;
+                    rewound = true;
+                    moveRopes(sim, true);
+                    if (sim->replay)
+                        rewindReplay(sim->replay, game->tick);
+                }
+                continue;
+            }
+            if (numPending == MAX_TICK_INPUTS)
+                continue;
+            InputAction input = stampInput(command->timestamp, sim->startTicks, command->kind, sim->localPlayer);
+            input.tick += sim->inputDelay;
+            if (input.tick < firstOpen) {
+                input.tick = firstOpen;
+                input.offset = 0;
+            }
+            // A command the other player will never hear of must not
+            // happen here either.
+            if (sim->online && !queueNetInput(net, &input))
+                continue;
+            pending[numPending++] = input;
+        }
+        sim->queueTail.store(tail, std::memory_order_release);
+        // Simulate every tick the clock has left `lag` ticks behind, as long
+        // as the other player's commands for it are in.
+        beginPerfPhase(PERF_UPDATE);
+        Uint32 firstTick = game->tick;
+        Uint32 now = SDL_GetTicks();
+        Uint32 clockTick = (Sint32)(now - sim->startTicks) > 0 ? (Uint32)((Uint64)(now - sim->startTicks) * SIM_RATE / 1000) : 0;
+        Uint32 lastTick = clockTick > (Uint32)sim->lag ? clockTick - sim->lag : 0;
+        if (sim->online) {
+            sendNetInputs(net, clockTick + sim->inputDelay);
+            if (!pollNet(net)) {
+                logTelemetry(TELEMETRY_NET_LOST, game->tick, 1 - sim->localPlayer, 0, 0, 0);
+                sim->online = false; // Their hook stays where it is
+            }
+        }
+        bool stalled = false;
+        while (game->tick < lastTick && !game->timeUp) {
+            if (sim->online && net->remoteConfirmed <= game->tick) {
+                net->stalls++;
+                stalled = true;
+                break;
+            }
+            InputAction inputs[MAX_TICK_INPUTS];
+            int n = 0, kept = 0;
+            for (int i = 0; i < numPending; i++) {
+                if (pending[i].tick == game->tick)
+                    inputs[n++] = pending[i];
+                else
+                    pending[kept++] = pending[i];
+            }
+            numPending = kept;
+            if (game->tick % SNAPSHOT_INTERVAL == 0)
+                pushSnapshot(&sim->snapshots, game);
+            if (sim->online)
+                n += takeNetInputs(net, game->tick, inputs + n, MAX_TICK_INPUTS - n);
+            if (sim->replay)
+                recordReplayInputs(sim->replay, inputs, n);
+            stepGame(game, inputs, n);
+            moveRopes(sim, false);
+            logGameEvents(game);
+        }
+        if (game->tick != firstTick || rewound)
+            publishView(sim, rewinds);
+        sim->busyTime += SDL_GetPerformanceCounter() - wake;
+        // Sleep until the clock reaches the next tick; while waiting on the
+        // other player, look again in a millisecond.
+        beginPerfPhase(PERF_IDLE);
+        Uint32 nextTicks = sim->startTicks + (Uint32)((Uint64)(game->tick + 1 + sim->lag) * 1000 / SIM_RATE);
+        Sint32 wait = (Sint32)(nextTicks - SDL_GetTicks());
+        if (stalled || wait > 0)
+            SDL_Delay(wait > 1 ? (Uint32)wait : 1);
+    }
+    sim->runTime = SDL_GetPerformanceCounter() - started;
+    if (sim->perfCounters) {
+        printPerfPhases("Perf counters, simulation thread", false);
+        closePerfCounters();
+    }
+    return 0;
+}
+
+bool startSimThread(SimThread* sim, Game* game, NetSession* net, int localPlayer, Uint32 startTicks, bool perfCounters,
+                    Replay* replay) {
+    sim->game = game;
+    sim->net = net;
+    sim->online = net != NULL;
+    sim->localPlayer = localPlayer;
+    sim->inputDelay = net ? net->inputDelay : 0;
+    sim->lag = net ? 0 : SIM_LOCAL_LAG;
+    sim->startTicks = startTicks;
+    sim->perfCounters = perfCounters;
+    sim->replay = replay;
+    clearSnapshots(&sim->snapshots);
+    sim->quit.store(false, std::memory_order_relaxed);
+    sim->queueHead.store(0, std::memory_order_relaxed);
+    sim->queueTail.store(0, std::memory_order_relaxed);
+    sim->busyTime = 0;
+    sim->runTime = 0;
+    initTripleBuffer(&sim->views);
+    moveRopes(sim, true);
+    publishView(sim, 0);
+    sim->thread = SDL_CreateThread(simWorker, "simulation", sim);
+    if (!sim->thread) {
+        printf("Error starting the simulation thread: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+bool sendSimCommand(SimThread* sim, const SimCommand* command) {
+    Uint32 head = sim->queueHead.load(std::memory_order_relaxed);
+    if (head - sim->queueTail.load(std::memory_order_acquire) == SIM_QUEUE_SIZE)
+        return false;
+    sim->queue[head & (SIM_QUEUE_SIZE - 1)] = *command;
+    sim->queueHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+const FrameView* latestFrameView(SimThread* sim) {
+    return &sim->frames[takeTripleBuffer(&sim->views)];
+}
+
+void stopSimThread(SimThread* sim) {
+    if (!sim->thread)
+        return;
+    sim->quit.store(true, std::memory_order_relaxed);
+    SDL_WaitThread(sim->thread, NULL);
+    sim->thread = NULL;
+}
+
+float simThreadBusy(const SimThread* sim) {
+    return sim->runTime > 0 ? (float)sim->busyTime / sim->runTime : 0.0f;
+}
@@ -0,0 +1,100 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include <SDL.h>
+#include <atomic>
+#include <stdbool.h>
+#include "game.h"
+#include "net.h"
+#include "replay.h"
+#include "rope.h"
+#include "snapshot.h"
+#include "triple_buffer.h"
+
+// Runs a round's simulation, networking included, on its own thread at
+// SIM_RATE, so that a slow present or texture upload on the main thread
+// never holds up the hooks. The main thread passes key presses in through
+// a lock-free queue and draws from the FrameView the simulation last
+// published through a triple buffer.
+
+#define SIM_QUEUE_SIZE 64             // Commands in flight; a power of two.
+
+// Alone, the simulation trails the clock by this many ticks, so that a key
+// press reaches it before the tick it was made in is simulated and keeps
+// its place inside that tick. Online, the input delay does the same.
+#define SIM_LOCAL_LAG 1
+
+#define FRAME_MAX_OBJECTS MINE_VIEW_MAX_OBJECTS
+
+typedef struct {
+    bool rewind;              // R: go back five seconds. Otherwise a key press:
+    InputKind kind;
+    Uint32 timestamp;         // SDL event time.
+} SimCommand;
+
+typedef struct {
+    SDL_Rect rect;            // In mine coordinates.
+    ObjectKind kind;
+} FrameObject;
+
+// Everything the main thread draws and plays sounds from, as of one tick.
+typedef struct {
+    Uint32 tick;
+    bool timeUp;
+    float timeLeft;
+    int cameraY;              // Top of the local player's view.
+    int numPlayers;
+    PlayerState players[MAX_PLAYERS];
+    SDL_Rect hookRects[MAX_PLAYERS];  // In mine coordinates.
+    int hookW, hookH;
+    SDL_Point hookPivot;
+    int rewinds;              // Times the round went back; the sounds restart.
+    RopePoints ropes[MAX_PLAYERS];
+    FrameObject objects[FRAME_MAX_OBJECTS];  // In the mine near the view.
+    int numObjects;
+} FrameView;
+
+typedef struct {
+    // The round, owned by the thread until stopSimThread returns.
+    Game* game;
+    NetSession* net;          // NULL when playing alone.
+    bool online;              // Still hearing from the other player.
+    int localPlayer;
+    int inputDelay;
+    int lag;                  // Ticks the simulation trails the clock.
+    Uint32 startTicks;        // SDL_GetTicks() of tick 0; moves on a rewind.
+    bool perfCounters;
+    Replay* replay;           // Records the round; NULL for none.
+    SnapshotRing snapshots;
+    Rope ropes[MAX_PLAYERS];  // Stepped with the game, but not part of it.
+    SDL_Thread* thread;
+    std::atomic<bool> quit;
+    alignas(64) std::atomic<Uint32> queueHead;  // Moved by the main thread only,
+    alignas(64) std::atomic<Uint32> queueTail;  // and this by the simulation.
+    SimCommand queue[SIM_QUEUE_SIZE];
+    FrameView frames[3];
+    TripleBuffer views;
+    Uint64 busyTime;          // Performance counter time spent working,
+    Uint64 runTime;           // and alive; read after stopSimThread.
+} SimThread;
+
+// Starts simulating `game` from its current tick. With `net`, the other
+// player's commands come from it and local ones go out through it. With
+// `replay`, begun by the caller, every tick's commands are recorded in it.
+// The first view is published before this returns.
+bool startSimThread(SimThread* sim, Game* game, NetSession* net, int localPlayer, Uint32 startTicks, bool perfCounters,
+                    Replay* replay);
+
+// Queues a command for the simulation. Returns false if the queue is full.
+bool sendSimCommand(SimThread* sim, const SimCommand* command);
+
+// The newest view. It stays valid and unchanged until the next call.
+const FrameView* latestFrameView(SimThread* sim);
+
+// Stops the thread, unless the round is already over, and waits for it.
+void stopSimThread(SimThread* sim);
+
+// Share of its life the simulation thread spent working, 0-1.
+float simThreadBusy(const SimThread* sim);
+
+#endif // SIM_THREAD_H
@@ -0,0 +1,42 @@
+#include "snapshot.h"
+#include <string.h>
+
+void clearSnapshots(SnapshotRing* ring) {
+    ring->newest = SNAPSHOT_RING - 1;
+    ring->count = 0;
+}
+
+void pushSnapshot(SnapshotRing* ring, const Game* game) {
+    if (ring->count == 0 || ring->states[ring->newest].tick != game->tick) {
+        ring->newest = (ring->newest + 1) % SNAPSHOT_RING;
+        if (ring->count < SNAPSHOT_RING)
+            ring->count++;
+    }
+    memcpy(&ring->states[ring->newest], game, sizeof(Game));
+}
+
+// Age 0 is the newest snapshot.
+static int slotOf(const SnapshotRing* ring, int age) {
+    return (ring->newest - age + SNAPSHOT_RING) % SNAPSHOT_RING;
+}
+
+const Game* findSnapshot(const SnapshotRing* ring, Uint32 tick) {
+    for (int age = 0; age < ring->count; age++) {
+        const Game* state = &ring->states[slotOf(ring, age)];
+        if (state->tick <= tick)
+            return state;
+    }
+    return NULL;
+}
+
+bool rollbackGame(SnapshotRing* ring, Game* game, Uint32 tick) {
+    if (ring->count == 0)
+        return false;
+    int age = 0;
+    while (age < ring->count - 1 && ring->states[slotOf(ring, age)].tick > tick)
+        age++;
+    ring->newest = slotOf(ring, age);
+    ring->count -= age;
+    restoreGame(game, &ring->states[ring->newest]);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Recent copies of the round, for going back in time. With one snapshot
+// every SNAPSHOT_INTERVAL ticks the ring reaches 8 seconds back.
+#define SNAPSHOT_RING 32
+#define SNAPSHOT_INTERVAL 15
+
+typedef struct {
+    Game states[SNAPSHOT_RING];
+    int newest;               // Slot of the newest snapshot.
+    int count;
+} SnapshotRing;
+
+void clearSnapshots(SnapshotRing* ring);
+
+// Stores a copy of the round, dropping the oldest one if the ring is full.
+// A snapshot of the same tick as the newest replaces it.
+void pushSnapshot(SnapshotRing* ring, const Game* game);
+
+// The newest snapshot at or before `tick`, or NULL if all are later.
+const Game* findSnapshot(const SnapshotRing* ring, Uint32 tick);
+
+// Puts the round back to the newest snapshot at or before `tick` (the
+// oldest one if none goes back that far) and forgets the snapshots after
+// it. Returns false if the ring is empty.
+bool rollbackGame(SnapshotRing* ring, Game* game, Uint32 tick);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,409 @@
+#include "soft_raster.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RASTER_HAS_SSE2
+#endif
+// AVX2 is compiled in per function and used only if the CPU reports it.
+#if defined(RASTER_HAS_SSE2) && defined(__GNUC__)
+#include <immintrin.h>
+#define RASTER_HAS_AVX2
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+// x * y / 255, rounded, for x and y in 0..255.
+static inline Uint32 mul255(Uint32 x, Uint32 y) {
+    Uint32 t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Per channel: src + dst * (255 - src alpha) / 255.
+static void blendRowScalar(Uint32* dst, const Uint32* src, int n) {
+    for (int i = 0; i < n; i++) {
+        Uint32 s = src[i], d = dst[i];
+        Uint32 inv = 255 - (s >> 24);
+        Uint32 out = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+            out |= (((s >> shift) & 0xFF) + mul255((d >> shift) & 0xFF, inv)) << shift;
+        dst[i] = out;
+    }
+}
+
+// Per channel: row * mod / 255, with mod's bytes lined up with the row's.
+static void modulateRowScalar(Uint32* row, int n, Uint32 mod) {
+    for (int i = 0; i < n; i++) {
+        Uint32 p = row[i], out = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+            out |= mul255((p >> shift) & 0xFF, (mod >> shift) & 0xFF) << shift;
+        row[i] = out;
+    }
+}
+
+#ifdef RASTER_HAS_SSE2
+// x / 255, rounded, on 16-bit lanes holding products of two bytes.
+static inline __m128i div255Sse2(__m128i x) {
+    __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Four pixels at a time: widen to 16 bits, spread each alpha over its
+// pixel's four lanes, then as blendRowScalar.
+static void blendRowSse2(Uint32* dst, const Uint32* src, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i sLo = _mm_unpacklo_epi8(s, zero), sHi = _mm_unpackhi_epi8(s, zero);
+        __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, 0xFF), 0xFF);
+        __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, 0xFF), 0xFF);
+        __m128i dLo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, aLo));
+        __m128i dHi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, aHi));
+        __m128i lo = _mm_add_epi16(sLo, div255Sse2(dLo));
+        __m128i hi = _mm_add_epi16(sHi, div255Sse2(dHi));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blendRowScalar(dst + i, src + i, n - i);
+}
+
+static void modulateRowSse2(Uint32* row, int n, Uint32 mod) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i m = _mm_unpacklo_epi8(_mm_set1_epi32((int)mod), zero);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(row + i));
+        __m128i lo = div255Sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), m));
+        __m128i hi = div255Sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), m));
+        _mm_storeu_si128((__m128i*)(row + i), _mm_packus_epi16(lo, hi));
+    }
+    modulateRowScalar(row + i, n - i, mod);
+}
+#endif
+
+#ifdef RASTER_HAS_AVX2
+AVX2_FUNCTION static inline __m256i div255Avx2(__m256i x) {
+    __m256i t = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// As blendRowSse2, eight pixels at a time. Unpacking and packing both work
+// within 128-bit halves, so the pixels come back out in order.
+AVX2_FUNCTION static void blendRowAvx2(Uint32* dst, const Uint32* src, int n) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(255);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i sLo = _mm256_unpacklo_epi8(s, zero), sHi = _mm256_unpackhi_epi8(s, zero);
+        __m256i aLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sLo, 0xFF), 0xFF);
+        __m256i aHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sHi, 0xFF), 0xFF);
+        __m256i dLo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, aLo));
+        __m256i dHi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, aHi));
+        __m256i lo = _mm256_add_epi16(sLo, div255Avx2(dLo));
+        __m256i hi = _mm256_add_epi16(sHi, div255Avx2(dHi));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    blendRowSse2(dst + i, src + i, n - i);
+}
+
+AVX2_FUNCTION static void modulateRowAvx2(Uint32* row, int n, Uint32 mod) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i m = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)mod), zero);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(row + i));
+        __m256i lo = div255Avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(p, zero), m));
+        __m256i hi = div255Avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(p, zero), m));
+        _mm256_storeu_si256((__m256i*)(row + i), _mm256_packus_epi16(lo, hi));
+    }
+    modulateRowSse2(row + i, n - i, mod);
+}
+
+AVX2_FUNCTION static void gatherRowAvx2(Uint32* out, const Uint32* src, const int* xs, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(xs + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_i32gather_epi32((const int*)src, index, 4));
+    }
+    for (; i < n; i++)
+        out[i] = src[xs[i]];
+}
+#endif
+
+static void blendRow(RasterSimd simd, Uint32* dst, const Uint32* src, int n) {
+#ifdef RASTER_HAS_AVX2
+    if (simd == RASTER_AVX2) {
+        blendRowAvx2(dst, src, n);
+        return;
+    }
+#endif
+#ifdef RASTER_HAS_SSE2
+    if (simd == RASTER_SSE2) {
+        blendRowSse2(dst, src, n);
+        return;
+    }
+#endif
+    blendRowScalar(dst, src, n);
+}
+
+static void modulateRow(RasterSimd simd, Uint32* row, int n, Uint32 mod) {
+#ifdef RASTER_HAS_AVX2
+    if (simd == RASTER_AVX2) {
+        modulateRowAvx2(row, n, mod);
+        return;
+    }
+#endif
+#ifdef RASTER_HAS_SSE2
+    if (simd == RASTER_SSE2) {
+        modulateRowSse2(row, n, mod);
+        return;
+    }
+#endif
+    modulateRowScalar(row, n, mod);
+}
+
+static void gatherRow(RasterSimd simd, Uint32* out, const Uint32* src, const int* xs, int n) {
+#ifdef RASTER_HAS_AVX2
+    if (simd == RASTER_AVX2) {
+        gatherRowAvx2(out, src, xs, n);
+        return;
+    }
+#endif
+    (void)simd;
+    for (int i = 0; i < n; i++)
+        out[i] = src[xs[i]];
+}
+
+// Scratch space for one band thread.
+typedef struct {
+    Uint32 row[RASTER_MAX_WIDTH];
+    int xs[RASTER_MAX_WIDTH];
+} BandScratch;
+
+static void runCopy(const Raster* raster, const RasterCommand* c, int top, int bottom, BandScratch* scratch) {
+    const RasterImage* image = c->image;
+    const SDL_Rect* src = &c->src;
+    const SDL_Rect* dst = &c->dst;
+    int x0 = dst->x > 0 ? dst->x : 0;
+    int x1 = dst->x + dst->w < raster->target->w ? dst->x + dst->w : raster->target->w;
+    int y0 = dst->y > top ? dst->y : top;
+    int y1 = dst->y + dst->h < bottom ? dst->y + dst->h : bottom;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    int n = x1 - x0;
+    bool scaled = src->w != dst->w;
+    // Nearest neighbour: each pixel takes the source pixel under its centre.
+    if (scaled) {
+        for (int x = x0; x < x1; x++)
+            scratch->xs[x - x0] = src->x + (int)(((Sint64)(x - dst->x) * 2 + 1) * src->w / (2 * (Sint64)dst->w));
+    }
+    Uint32 mod = (Uint32)mul255(c->color.r, c->color.a) << 16 | (Uint32)mul255(c->color.g, c->color.a) << 8 |
+                 (Uint32)mul255(c->color.b, c->color.a) | (Uint32)c->color.a << 24;
+    bool modulated = mod != 0xFFFFFFFFu;
+    bool blended = !image->opaque || c->color.a < 255;
+    for (int y = y0; y < y1; y++) {
+        int sy = src->y + (int)(((Sint64)(y - dst->y) * 2 + 1) * src->h / (2 * (Sint64)dst->h));
+        const Uint32* srcRow = image->pixels + (size_t)sy * image->pitch;
+        const Uint32* s = srcRow + src->x + (x0 - dst->x);
+        if (scaled) {
+            gatherRow(raster->simd, scratch->row, srcRow, scratch->xs, n);
+            s = scratch->row;
+        }
+        if (modulated) {
+            if (s != scratch->row)
+                memcpy(scratch->row, s, (size_t)n * sizeof(Uint32));
+            modulateRow(raster->simd, scratch->row, n, mod);
+            s = scratch->row;
+        }
+        Uint32* d = (Uint32*)((Uint8*)raster->target->pixels + (size_t)y * raster->target->pitch) + x0;
+        if (blended)
+            blendRow(raster->simd, d, s, n);
+        else
+            memcpy(d, s, (size_t)n * sizeof(Uint32));
+    }
+}
+
+// One-pixel line; each band draws the points that fall in it.
+static void runLine(const Raster* raster, const RasterCommand* c, int top, int bottom) {
+    int x = c->dst.x, y = c->dst.y, x2 = c->dst.w, y2 = c->dst.h;
+    if ((y < top && y2 < top) || (y >= bottom && y2 >= bottom))
+        return;
+    Uint32 a = c->color.a;
+    Uint32 color = a << 24 | mul255(c->color.r, a) << 16 | mul255(c->color.g, a) << 8 | mul255(c->color.b, a);
+    int dx = abs(x2 - x), sx = x < x2 ? 1 : -1;
+    int dy = -abs(y2 - y), sy = y < y2 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (y >= top && y < bottom && x >= 0 && x < raster->target->w) {
+            Uint32* d = (Uint32*)((Uint8*)raster->target->pixels + (size_t)y * raster->target->pitch) + x;
+            blendRowScalar(d, &color, 1);
+        }
+        if (x == x2 && y == y2)
+            break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+// Takes bands until none are left, running every command on each.
+static void runBands(Raster* raster) {
+    static thread_local BandScratch scratch;
+    for (;;) {
+        int top = SDL_AtomicAdd(&raster->nextBand, 1) * RASTER_BAND_ROWS;
+        if (top >= raster->target->h)
+            return;
+        int bottom = top + RASTER_BAND_ROWS < raster->target->h ? top + RASTER_BAND_ROWS : raster->target->h;
+        for (int i = 0; i < raster->numCommands; i++) {
+            const RasterCommand* c = &raster->commands[i];
+            if (c->kind == RASTER_COPY)
+                runCopy(raster, c, top, bottom, &scratch);
+            else
+                runLine(raster, c, top, bottom);
+        }
+    }
+}
+
+static int rasterWorker(void* data) {
+    Raster* raster = (Raster*)data;
+    for (;;) {
+        SDL_SemWait(raster->start);
+        if (raster->quit)
+            return 0;
+        runBands(raster);
+        SDL_SemPost(raster->done);
+    }
+}
+
+bool initRasterImage(RasterImage* image, SDL_Surface* surface, Arena* arena) {
+    memset(image, 0, sizeof(RasterImage));
+    if (!surface)
+        return false;
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!argb) {
+        printf("Error converting image: %s\n", SDL_GetError());
+        return false;
+    }
+    image->w = argb->w;
+    image->h = argb->h;
+    image->pitch = argb->w;
+    image->arena = arena;
+    image->pixels = (Uint32*)arenaAlloc(arena, (size_t)image->pitch * image->h * sizeof(Uint32));
+    image->opaque = true;
+    for (int y = 0; y < image->h && image->pixels; y++) {
+        const Uint32* in = (const Uint32*)((const Uint8*)argb->pixels + (size_t)y * argb->pitch);
+        Uint32* out = image->pixels + (size_t)y * image->pitch;
+        for (int x = 0; x < image->w; x++) {
+            Uint32 p = in[x], a = p >> 24;
+            out[x] = a << 24 | mul255((p >> 16) & 0xFF, a) << 16 | mul255((p >> 8) & 0xFF, a) << 8 | mul255(p & 0xFF, a);
+            image->opaque = image->opaque && a == 255;
+        }
+    }
+    SDL_FreeSurface(argb);
+    return image->pixels != NULL;
+}
+
+void freeRasterImage(RasterImage* image) {
+    arenaFree(image->arena, image->pixels);
+    memset(image, 0, sizeof(RasterImage));
+}
+
+bool initRaster(Raster* raster, SDL_Surface* target, int threads) {
+    memset(raster, 0, sizeof(Raster));
+    const SDL_PixelFormat* f = target ? target->format : NULL;
+    if (!f || f->BytesPerPixel != 4 || f->Rmask != 0xFF0000 || f->Gmask != 0xFF00 || f->Bmask != 0xFF ||
+        target->w > RASTER_MAX_WIDTH) {
+        printf("Soft raster needs a 32-bit XRGB target up to %d wide\n", RASTER_MAX_WIDTH);
+        return false;
+    }
+    raster->target = target;
+    raster->simd = RASTER_SCALAR;
+#ifdef RASTER_HAS_SSE2
+    raster->simd = RASTER_SSE2;
+#endif
+#ifdef RASTER_HAS_AVX2
+    if (SDL_HasAVX2())
+        raster->simd = RASTER_AVX2;
+#endif
+    if (threads <= 0)
+        threads = SDL_GetCPUCount();
+    raster->start = SDL_CreateSemaphore(0);
+    raster->done = SDL_CreateSemaphore(0);
+    for (int i = 0; i < threads - 1 && i < RASTER_MAX_THREADS && raster->start && raster->done; i++) {
+        raster->threads[i] = SDL_CreateThread(rasterWorker, "raster", raster);
+        if (!raster->threads[i])
+            break;
+        raster->numThreads++;
+    }
+    return true;
+}
+
+static void addCommand(Raster* raster, const RasterCommand* command) {
+    if (raster->numCommands == RASTER_MAX_COMMANDS)
+        flushRaster(raster);
+    raster->commands[raster->numCommands++] = *command;
+}
+
+void rasterCopy(Raster* raster, const RasterImage* image, const SDL_Rect* src, const SDL_Rect* dst, SDL_Color mod) {
+    if (!image->pixels || dst->w <= 0 || dst->h <= 0)
+        return;
+    RasterCommand c;
+    c.kind = RASTER_COPY;
+    c.image = image;
+    c.src = src ? *src : (SDL_Rect){0, 0, image->w, image->h};
+    c.dst = *dst;
+    c.color = mod;
+    if (c.src.x < 0 || c.src.y < 0 || c.src.w <= 0 || c.src.h <= 0 || c.src.x + c.src.w > image->w ||
+        c.src.y + c.src.h > image->h)
+        return;
+    addCommand(raster, &c);
+}
+
+void rasterLine(Raster* raster, int x1, int y1, int x2, int y2, SDL_Color color) {
+    RasterCommand c;
+    c.kind = RASTER_LINE;
+    c.image = NULL;
+    c.src = (SDL_Rect){0, 0, 0, 0};
+    c.dst = (SDL_Rect){x1, y1, x2, y2};
+    c.color = color;
+    addCommand(raster, &c);
+}
+
+void flushRaster(Raster* raster) {
+    if (raster->numCommands == 0)
+        return;
+    if (SDL_MUSTLOCK(raster->target))
+        SDL_LockSurface(raster->target);
+    SDL_AtomicSet(&raster->nextBand, 0);
+    for (int i = 0; i < raster->numThreads; i++)
+        SDL_SemPost(raster->start);
+    runBands(raster);
+    for (int i = 0; i < raster->numThreads; i++)
+        SDL_SemWait(raster->done);
+    if (SDL_MUSTLOCK(raster->target))
+        SDL_UnlockSurface(raster->target);
+    raster->numCommands = 0;
+}
+
+void freeRaster(Raster* raster) {
+    raster->quit = true;
+    for (int i = 0; i < raster->numThreads; i++)
+        SDL_SemPost(raster->start);
+    for (int i = 0; i < raster->numThreads; i++)
+        SDL_WaitThread(raster->threads[i], NULL);
+    if (raster->start)
+        SDL_DestroySemaphore(raster->start);
+    if (raster->done)
+        SDL_DestroySemaphore(raster->done);
+    memset(raster, 0, sizeof(Raster));
+}
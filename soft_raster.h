@@ -0,0 +1,86 @@
+#ifndef SOFT_RASTER_H
+#define SOFT_RASTER_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "arena.h"
+
+// A CPU renderer for the few things the playfield draws: the background
+// copy, scaled sprites, the pre-turned hook frames and the rope. It draws
+// straight into a 32-bit surface (the window's, with --soft-raster) and is
+// for machines where SDL_Renderer ends up on its generic software backend,
+// whose scaled alpha blits are slow.
+//
+// Drawing is recorded, then flushRaster splits the target into bands of
+// rows and runs every command on each band, one band per thread at a time.
+// Sprites are scaled nearest-neighbour, as SDL's software renderer does,
+// and blended premultiplied, with SSE2 or AVX2 where the CPU has them.
+
+#define RASTER_MAX_COMMANDS 1024
+#define RASTER_MAX_THREADS 8
+#define RASTER_BAND_ROWS 32
+#define RASTER_MAX_WIDTH 4096
+
+// Premultiplied ARGB, converted once from a surface.
+typedef struct {
+    Uint32* pixels;
+    int w, h;
+    int pitch;                // In pixels.
+    bool opaque;              // Every alpha is 255: copies skip blending.
+    Arena* arena;             // The pixels'; NULL for the heap.
+} RasterImage;
+
+typedef enum {
+    RASTER_SCALAR,
+    RASTER_SSE2,
+    RASTER_AVX2
+} RasterSimd;
+
+typedef enum {
+    RASTER_COPY,
+    RASTER_LINE
+} RasterCommandKind;
+
+typedef struct {
+    RasterCommandKind kind;
+    const RasterImage* image;
+    SDL_Rect src, dst;        // For a line, dst holds the two end points.
+    SDL_Color color;          // Colour and alpha mod for a copy; the colour of a line.
+} RasterCommand;
+
+typedef struct {
+    SDL_Surface* target;
+    RasterCommand commands[RASTER_MAX_COMMANDS];
+    int numCommands;
+    RasterSimd simd;          // Best the CPU has; may be lowered to compare.
+    int numThreads;           // Helpers besides the flushing thread.
+    SDL_Thread* threads[RASTER_MAX_THREADS];
+    SDL_sem* start;
+    SDL_sem* done;
+    SDL_atomic_t nextBand;
+    bool quit;
+} Raster;
+
+// Converts `surface` to premultiplied pixels, kept in `arena` (NULL for the
+// heap). Touches no renderer, so it can run on a loader thread. An image
+// with no pixels draws nothing.
+bool initRasterImage(RasterImage* image, SDL_Surface* surface, Arena* arena);
+void freeRasterImage(RasterImage* image);
+
+// `target` must be 32-bit XRGB or ARGB. `threads` counts every thread that
+// draws, the caller's included; 0 means one per core.
+bool initRaster(Raster* raster, SDL_Surface* target, int threads);
+
+// Like SDL_RenderCopy with the texture's colour and alpha mod set to
+// `mod`. A NULL src is the whole image.
+void rasterCopy(Raster* raster, const RasterImage* image, const SDL_Rect* src, const SDL_Rect* dst, SDL_Color mod);
+
+void rasterLine(Raster* raster, int x1, int y1, int x2, int y2, SDL_Color color);
+
+// Draws everything recorded since the last flush, in order, and waits for
+// it to finish.
+void flushRaster(Raster* raster);
+
+void freeRaster(Raster* raster);
+
+#endif // SOFT_RASTER_H
@@ -0,0 +1,214 @@
+#include "telemetry.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+// One thread's records. Only the owning thread moves head and only the
+// writer moves tail, so each side needs just an acquire load of the other
+// index and a release store of its own, which on x86 are plain moves.
+typedef struct {
+    alignas(64) std::atomic<Uint32> head;
+    alignas(64) std::atomic<Uint32> tail;
+    std::atomic<Uint32> dropped;       // Records lost because the ring was full.
+    std::atomic<bool> owned;
+    TelemetryRecord records[TELEMETRY_RING_SIZE];
+} TelemetryRing;
+
+// Hands a thread's ring back when the thread exits, so short-lived threads
+// such as the preload worker do not use up the slots. The next owner carries
+// on from the same head and tail.
+struct RingOwner {
+    TelemetryRing* ring = NULL;
+    ~RingOwner() {
+        if (ring != NULL)
+            ring->owned.store(false, std::memory_order_release);
+    }
+};
+
+static TelemetryRing rings[TELEMETRY_MAX_THREADS];
+static thread_local RingOwner localRing;
+static std::atomic<bool> logging;
+static std::atomic<Uint32> clockMs;
+
+// Writer thread state.
+static SDL_Thread* writer;
+static SDL_sem* wake;
+static FILE* file;
+static long fileBytes;
+static char basePath[64];
+static Uint32 droppedSeen[TELEMETRY_MAX_THREADS];
+
+static const char* KIND_NAMES[NUM_TELEMETRY_KINDS] = {
+    "grab", "miss", "wall_hit", "dynamite", "catch", "mystery", "round_end", "mine_full",
+    "frame_spike", "net_lost", "dropped",
+};
+
+const char* telemetryKindName(int kind) {
+    return kind >= 0 && kind < NUM_TELEMETRY_KINDS ? KIND_NAMES[kind] : "unknown";
+}
+
+static TelemetryRing* claimRing(void) {
+    for (int i = 0; i < TELEMETRY_MAX_THREADS; i++) {
+        bool expected = false;
+        if (rings[i].owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            localRing.ring = &rings[i];
+            return &rings[i];
+        }
+    }
+    return NULL;
+}
+
+void setTelemetryTime(Uint32 ms) {
+    clockMs.store(ms, std::memory_order_relaxed);
+}
+
+void logTelemetry(int kind, Uint32 tick, int player, int detail, int a, int b) {
+    if (!logging.load(std::memory_order_relaxed))
+        return;
+    TelemetryRing* ring = localRing.ring;
+    if (ring == NULL && (ring = claimRing()) == NULL)
+        return;
+    Uint32 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) == TELEMETRY_RING_SIZE) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TelemetryRecord* r = &ring->records[head & (TELEMETRY_RING_SIZE - 1)];
+    r->ms = clockMs.load(std::memory_order_relaxed);
+    r->tick = tick;
+    r->kind = (Uint8)kind;
+    r->player = (Uint8)player;
+    r->detail = (Uint16)detail;
+    r->a = a;
+    r->b = b;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void logGameEvents(const Game* game) {
+    for (int i = 0; i < game->numEvents; i++) {
+        const GameEvent* e = &game->events[i];
+        logTelemetry(e->kind, game->tick - 1, e->player, e->detail, e->a, e->b);
+    }
+}
+
+static void logPath(char* out, size_t outSize, int age) {
+    if (age == 0)
+        snprintf(out, outSize, "%s.bin", basePath);
+    else
+        snprintf(out, outSize, "%s.%d.bin", basePath, age);
+}
+
+// Moves the existing files one age up, dropping the oldest, and starts a
+// new current file.
+static bool openLogFile(void) {
+    char from[80], to[80];
+    for (int age = TELEMETRY_KEEP_FILES - 1; age > 0; age--) {
+        logPath(from, sizeof(from), age - 1);
+        logPath(to, sizeof(to), age);
+        remove(to);
+        rename(from, to);
+    }
+    logPath(to, sizeof(to), 0);
+    file = fopen(to, "wb");
+    if (file == NULL) {
+        printf("Error opening telemetry log %s\n", to);
+        return false;
+    }
+    TelemetryFileHeader header = {TELEMETRY_MAGIC, TELEMETRY_VERSION, (Uint16)sizeof(TelemetryRecord)};
+    fileBytes = (long)fwrite(&header, 1, sizeof(header), file);
+    return true;
+}
+
+static void writeRecords(const TelemetryRecord* records, Uint32 count) {
+    if (file == NULL || count == 0)
+        return;
+    if (fileBytes >= TELEMETRY_FILE_BYTES) {
+        fclose(file);
+        if (!openLogFile())
+            return;
+    }
+    if (fwrite(records, sizeof(TelemetryRecord), count, file) != count) {
+        printf("Error writing telemetry log; logging stops\n");
+        fclose(file);
+        file = NULL;
+        return;
+    }
+    fileBytes += (long)(count * sizeof(TelemetryRecord));
+}
+
+static void drainRings(void) {
+    for (int i = 0; i < TELEMETRY_MAX_THREADS; i++) {
+        TelemetryRing* ring = &rings[i];
+        Uint32 tail = ring->tail.load(std::memory_order_relaxed);
+        Uint32 head = ring->head.load(std::memory_order_acquire);
+        // Up to the end of the array, then the part that wrapped round.
+        while (tail != head) {
+            Uint32 at = tail & (TELEMETRY_RING_SIZE - 1);
+            Uint32 count = head - tail;
+            if (count > TELEMETRY_RING_SIZE - at)
+                count = TELEMETRY_RING_SIZE - at;
+            writeRecords(&ring->records[at], count);
+            tail += count;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        Uint32 dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped != droppedSeen[i]) {
+            TelemetryRecord r = {clockMs.load(std::memory_order_relaxed), 0, TELEMETRY_DROPPED, 0, 0,
+                                 (Sint32)(dropped - droppedSeen[i]), 0};
+            writeRecords(&r, 1);
+            droppedSeen[i] = dropped;
+        }
+    }
+    if (file != NULL)
+        fflush(file);
+}
+
+static int telemetryWriter(void* data) {
+    (void)data;
+    bool stopping = false;
+    while (!stopping) {
+        SDL_SemWaitTimeout(wake, TELEMETRY_FLUSH_MS);
+        stopping = !logging.load(std::memory_order_acquire);
+        drainRings();
+    }
+    return 0;
+}
+
+bool startTelemetry(const char* base) {
+    if (writer != NULL)
+        return true;
+    snprintf(basePath, sizeof(basePath), "%s", base);
+    if (!openLogFile())
+        return false;
+    // Touch the rings now so that first use in a round does not page-fault.
+    for (int i = 0; i < TELEMETRY_MAX_THREADS; i++)
+        memset(rings[i].records, 0, sizeof(rings[i].records));
+    wake = SDL_CreateSemaphore(0);
+    logging.store(true, std::memory_order_release);
+    writer = wake != NULL ? SDL_CreateThread(telemetryWriter, "telemetry", NULL) : NULL;
+    if (writer == NULL) {
+        printf("Telemetry thread error: %s\n", SDL_GetError());
+        logging.store(false, std::memory_order_release);
+        if (wake != NULL)
+            SDL_DestroySemaphore(wake);
+        wake = NULL;
+        fclose(file);
+        file = NULL;
+        return false;
+    }
+    return true;
+}
+
+void stopTelemetry(void) {
+    if (writer == NULL)
+        return;
+    logging.store(false, std::memory_order_release);
+    SDL_SemPost(wake);
+    SDL_WaitThread(writer, NULL);
+    writer = NULL;
+    SDL_DestroySemaphore(wake);
+    wake = NULL;
+    if (file != NULL)
+        fclose(file);
+    file = NULL;
+}
@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Binary event log for balancing and performance analysis. Logging a
+// record copies it into a ring owned by the calling thread, with no lock
+// or system call; a background thread drains the rings into
+// <base>.bin, moving full files on to <base>.1.bin, <base>.2.bin and so on.
+// tools/telecsv.cpp turns the files into CSV.
+
+#define TELEMETRY_MAGIC 0x4C544744u   // "DGTL"
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_RING_SIZE 4096      // Records per thread; a power of two.
+#define TELEMETRY_MAX_THREADS 8
+#define TELEMETRY_FILE_BYTES (4 * 1024 * 1024)
+#define TELEMETRY_KEEP_FILES 4        // The current file and three old ones.
+#define TELEMETRY_FLUSH_MS 100
+
+// Frames longer than this are logged as spikes.
+#define TELEMETRY_SPIKE_US 25000
+
+// Record kinds: the game's own events (GameEventKind), then these.
+//   FRAME_SPIKE  -, frame time in microseconds, -
+//   NET_LOST     -, -, -                      (the other player went quiet)
+//   DROPPED      -, records lost to full rings, -
+typedef enum {
+    TELEMETRY_FRAME_SPIKE = NUM_GAME_EVENTS,
+    TELEMETRY_NET_LOST,
+    TELEMETRY_DROPPED,
+    NUM_TELEMETRY_KINDS
+} TelemetryKind;
+
+typedef struct {
+    Uint32 magic;
+    Uint16 version;
+    Uint16 recordSize;
+} TelemetryFileHeader;
+
+typedef struct {
+    Uint32 ms;                // SDL_GetTicks() of the frame it was logged in.
+    Uint32 tick;
+    Uint8 kind;
+    Uint8 player;
+    Uint16 detail;
+    Sint32 a, b;
+} TelemetryRecord;
+
+// Opens <base>.bin and starts the writer thread. Until this succeeds,
+// logging does nothing.
+bool startTelemetry(const char* base);
+
+// Stops the writer after it has written everything logged so far.
+void stopTelemetry(void);
+
+// Sets the time stamped on records; call once per frame.
+void setTelemetryTime(Uint32 ms);
+
+void logTelemetry(int kind, Uint32 tick, int player, int detail, int a, int b);
+
+// Logs the events of the tick the game last simulated.
+void logGameEvents(const Game* game);
+
+// Name of a record kind, for the decoder.
+const char* telemetryKindName(int kind);
+
+#endif // TELEMETRY_H
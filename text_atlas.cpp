@@ -0,0 +1,115 @@
+#include "text_atlas.h"
+#include <math.h>
+#include <stdio.h>
+#include "alloc_track.h"
+
+// Bilinear sample of a glyph's field at texel coordinates (u, v) in its
+// cell. Beyond the cell is as far outside the glyph as the field goes.
+static float sampleField(const SdfFont* font, const SdfGlyph* g, float u, float v) {
+    int x0 = (int)floorf(u);
+    int y0 = (int)floorf(v);
+    float fx = u - x0, fy = v - y0;
+    float s[2][2];
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            int x = x0 + i, y = y0 + j;
+            bool in = x >= 0 && y >= 0 && x < g->w && y < g->h;
+            s[j][i] = in ? font->pixels[(g->y + y) * font->header->atlasWidth + g->x + x] : 0.0f;
+        }
+    }
+    float top = s[0][0] + (s[0][1] - s[0][0]) * fx;
+    float bottom = s[1][0] + (s[1][1] - s[1][0]) * fx;
+    return top + (bottom - top) * fy;
+}
+
+bool initTextAtlas(TextAtlas* atlas, SDL_Renderer* renderer, const SdfFont* font, int size) {
+    atlas->texture = NULL;
+    const SdfHeader* header = font->header;
+    float scale = (float)size / SDF_BAKE_SIZE;
+    atlas->height = (int)(header->lineHeight * scale + 0.5f);
+    // The field's padding, scaled, keeps room for the edge's soft pixels.
+    atlas->padding = (int)ceilf(SDF_SPREAD * scale);
+    // Lay the glyphs out in rows first to know how tall the atlas is.
+    int x = 0, y = 0, rowHeight = 0;
+    for (int i = 0; i < TEXT_NUM_CHARS; i++) {
+        const SdfGlyph* g = &header->glyphs[i];
+        atlas->advance[i] = (int)(g->advance * scale + 0.5f);
+        SDL_Rect r = {0, 0, 0, 0};
+        if (g->w > 0) {
+            r.w = (int)ceilf((g->w - 2 * SDF_SPREAD) * scale) + 2 * atlas->padding;
+            r.h = (int)ceilf((g->h - 2 * SDF_SPREAD) * scale) + 2 * atlas->padding;
+        }
+        if (x + r.w > TEXT_ATLAS_WIDTH) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        r.x = x;
+        r.y = y;
+        atlas->glyphs[i] = r;
+        x += r.w;
+        if (r.h > rowHeight)
+            rowHeight = r.h;
+    }
+    SDL_Surface* sheet = trackedCreateSurface(TEXT_ATLAS_WIDTH, y + rowHeight);
+    if (!sheet) {
+        printf("Error creating text atlas: %s\n", SDL_GetError());
+        return false;
+    }
+    // Coverage is how far a pixel's centre is inside the edge, in pixels of
+    // this size, so the edge is one pixel soft whatever the scale.
+    float toPixels = SDF_SPREAD * scale / 127.5f;
+    for (int i = 0; i < TEXT_NUM_CHARS; i++) {
+        const SdfGlyph* g = &header->glyphs[i];
+        const SDL_Rect* r = &atlas->glyphs[i];
+        for (int py = 0; py < r->h; py++) {
+            Uint32* row = (Uint32*)((Uint8*)sheet->pixels + (r->y + py) * sheet->pitch) + r->x;
+            float v = (py - atlas->padding + 0.5f) / scale + SDF_SPREAD - 0.5f;
+            for (int px = 0; px < r->w; px++) {
+                float u = (px - atlas->padding + 0.5f) / scale + SDF_SPREAD - 0.5f;
+                float coverage = (sampleField(font, g, u, v) - 127.5f) * toPixels + 0.5f;
+                coverage = coverage < 0.0f ? 0.0f : coverage > 1.0f ? 1.0f : coverage;
+                row[px] = (Uint32)(coverage * 255.0f + 0.5f) << 24 | 0xFFFFFFu;
+            }
+        }
+    }
+    atlas->texture = trackedCreateTextureFromSurface(renderer, sheet);
+    trackedFreeSurface(sheet);
+    if (!atlas->texture) {
+        printf("Error creating text atlas texture: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+int measureText(const TextAtlas* atlas, const char* text) {
+    int width = 0;
+    for (const char* c = text; *c; c++) {
+        int i = (unsigned char)*c - TEXT_FIRST_CHAR;
+        if (i >= 0 && i < TEXT_NUM_CHARS)
+            width += atlas->advance[i];
+    }
+    return width;
+}
+
+int drawText(const TextAtlas* atlas, SDL_Renderer* renderer, const char* text, int x, int y) {
+    int startX = x;
+    for (const char* c = text; *c; c++) {
+        int i = (unsigned char)*c - TEXT_FIRST_CHAR;
+        if (i < 0 || i >= TEXT_NUM_CHARS)
+            continue;
+        const SDL_Rect* src = &atlas->glyphs[i];
+        if (src->w > 0 && atlas->texture) {
+            SDL_Rect dst = {x - atlas->padding, y - atlas->padding, src->w, src->h};
+            SDL_RenderCopy(renderer, atlas->texture, src, &dst);
+        }
+        x += atlas->advance[i];
+    }
+    return x - startX;
+}
+
+void freeTextAtlas(TextAtlas* atlas) {
+    trackedDestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+}
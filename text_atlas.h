@@ -0,0 +1,39 @@
+#ifndef TEXT_ATLAS_H
+#define TEXT_ATLAS_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include "sdf_font.h"
+
+// Printable ASCII at one size, rendered once into a single texture. Drawing
+// a string is then just a copy per character: no surfaces or textures are
+// made per frame, which TTF_RenderText would do.
+//
+// The glyphs come from the baked distance field, which has one sample per
+// pixel at SDF_BAKE_SIZE. SDL's renderer cannot run a shader over it, so
+// the field is turned into plain coverage for the size asked for here,
+// once: that is a few milliseconds and needs no FreeType.
+#define TEXT_FIRST_CHAR SDF_FIRST_CHAR
+#define TEXT_NUM_CHARS SDF_NUM_CHARS
+#define TEXT_ATLAS_WIDTH 512
+
+typedef struct {
+    SDL_Texture* texture;
+    SDL_Rect glyphs[TEXT_NUM_CHARS];  // Where each character is in the texture.
+    int advance[TEXT_NUM_CHARS];
+    int height;
+    int padding;              // Each glyph's rectangle starts this far above and left of the pen.
+} TextAtlas;
+
+// `size` is in points, as for TTF_OpenFont.
+bool initTextAtlas(TextAtlas* atlas, SDL_Renderer* renderer, const SdfFont* font, int size);
+
+// Width of `text` in pixels. Characters outside the atlas take no room.
+int measureText(const TextAtlas* atlas, const char* text);
+
+// Draws white `text` with its top-left corner at (x, y). Returns its width.
+int drawText(const TextAtlas* atlas, SDL_Renderer* renderer, const char* text, int x, int y);
+
+void freeTextAtlas(TextAtlas* atlas);
+
+#endif // TEXT_ATLAS_H
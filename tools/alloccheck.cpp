@@ -0,0 +1,166 @@
+// Allocation check: plays scripted two-player rounds of every authored
+// level and a few generated ones through the per-frame gameplay work
+// (stepGame and the mine streaming it drives, a rewind, the particles and
+// the ropes) and fails if any frame after ALLOC_WARMUP_FRAMES allocates.
+// Run by "make check".
+//
+// The Makefile links it with --wrap for malloc, calloc and realloc, so
+// plain malloc from the game code is counted here along with operator new
+// and SDL's heap, which the game's own --alloc-stats cannot see.
+//
+//   alloccheck
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../alloc_track.h"
+#include "../game.h"
+#include "../level_gen.h"
+#include "../particles.h"
+#include "../rope.h"
+#include "../snapshot.h"
+
+#define ALLOCCHECK_ROUNDS 2
+#define ALLOCCHECK_ENDLESS_LEVELS 3
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* mem, size_t size);
+}
+
+static int mallocs;
+
+extern "C" void* __wrap_malloc(size_t size) {
+    mallocs++;
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t nmemb, size_t size) {
+    mallocs++;
+    return __real_calloc(nmemb, size);
+}
+
+extern "C" void* __wrap_realloc(void* mem, size_t size) {
+    mallocs++;
+    return __real_realloc(mem, size);
+}
+
+static SnapshotRing snapshots;
+static Rope ropes[MAX_PLAYERS];
+
+static int countAllocs(void) {
+    return mallocs + readAllocCounts().heapAllocs;
+}
+
+static Uint32 nextScript(Uint32* state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+static void moveRopes(const Game* game, bool reset) {
+    for (int i = 0; i < game->numPlayers; i++) {
+        const PlayerState* p = &game->players[i];
+        SDL_Rect rect = hookRect(game, p);
+        float hookX = (float)(rect.x + game->hookPivot.x), hookY = (float)(rect.y + game->hookPivot.y);
+        if (reset)
+            resetRope(&ropes[i], p->anchorX, p->anchorY, hookX, hookY);
+        else
+            stepRope(&ropes[i], p->anchorX, p->anchorY, hookX, hookY, ROPE_SLACK, SIM_DT);
+    }
+}
+
+// One round driven like simrun's. Returns the frames past warm-up that
+// allocated.
+static int checkRound(Level* level, int index, Uint32 seed, Particles* particles, int* checkedFrames) {
+    Mine mine;
+    if (!initMine(&mine, level, NULL))
+        return 1;
+    Game game;
+    initGame(&game, level->header, &mine, 2, seed);
+    clearSnapshots(&snapshots);
+    clearParticles(particles);
+    moveRopes(&game, true);
+    HookState lastStates[MAX_PLAYERS] = {OSCILLATING, OSCILLATING};
+    Uint32 script = seed;
+    bool rewound = false;
+    int frames = 0, failed = 0;
+    while (!game.timeUp) {
+        int before = countAllocs();
+        InputAction inputs[MAX_PLAYERS];
+        int n = 0;
+        for (int i = 0; i < game.numPlayers; i++) {
+            Uint32 roll = nextScript(&script);
+            HookState state = game.players[i].hookState;
+            if ((state == OSCILLATING && roll % 40 == 0) || (state == PULLING_GOLD && roll % 200 == 0)) {
+                InputAction* input = &inputs[n++];
+                input->tick = game.tick;
+                input->offset = (Uint8)(roll >> 12);
+                input->kind = state == OSCILLATING ? INPUT_RELEASE : INPUT_DYNAMITE;
+                input->player = (Uint8)i;
+            }
+        }
+        if (game.tick % SNAPSHOT_INTERVAL == 0)
+            pushSnapshot(&snapshots, &game);
+        stepGame(&game, inputs, n);
+        bool rewind = !rewound && game.tick == game.tuning->timeLimit * SIM_RATE / 2;
+        if (rewind) {
+            rollbackGame(&snapshots, &game, game.tick - SIM_RATE);
+            rewound = true;
+        }
+        moveRopes(&game, rewind);
+        for (int i = 0; i < game.numPlayers; i++) {
+            const PlayerState* p = &game.players[i];
+            if (p->hookState == dynamite_EXPLOSION && lastStates[i] != dynamite_EXPLOSION)
+                spawnExplosion(particles, p->explosionX, p->explosionY);
+            lastStates[i] = p->hookState;
+        }
+        updateParticles(particles, SIM_DT);
+        int allocs = countAllocs() - before;
+        if (++frames > ALLOC_WARMUP_FRAMES) {
+            (*checkedFrames)++;
+            if (allocs > 0) {
+                printf("Level %d, seed %u, tick %u: %d heap allocations\n", index, seed, game.tick, allocs);
+                failed++;
+            }
+        }
+    }
+    freeMine(&mine);
+    return failed;
+}
+
+static int checkLevel(Level* level, int index, Particles* particles, int* checkedFrames) {
+    int failed = 0;
+    for (int r = 0; r < ALLOCCHECK_ROUNDS; r++)
+        failed += checkRound(level, index, (Uint32)(index * 7919 + r + 1), particles, checkedFrames);
+    return failed;
+}
+
+int main() {
+    startAllocTracking();
+    Particles particles;
+    if (!initParticles(&particles))
+        return 1;
+    int index = 1, checkedFrames = 0, failed = 0;
+    char path[LEVEL_PATH_LEN];
+    Level level;
+    for (; findLevelFile(index, path, sizeof(path)); index++) {
+        if (!loadLevel(path, &level, NULL))
+            return 1;
+        failed += checkLevel(&level, index, &particles, &checkedFrames);
+        freeLevel(&level);
+    }
+    for (int i = 0; i < ALLOCCHECK_ENDLESS_LEVELS; i++, index++) {
+        if (!generateEndlessLevel(index, &level, NULL))
+            return 1;
+        failed += checkLevel(&level, index, &particles, &checkedFrames);
+        freeLevel(&level);
+    }
+    freeParticles(&particles);
+    if (failed > 0) {
+        printf("Allocation check FAILED: %d of %d frames after warm-up allocated\n", failed, checkedFrames);
+        return 1;
+    }
+    printf("Allocation check passed: %d frames after warm-up made no allocations\n", checkedFrames);
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Arena check: grows standard containers through ArenaResource over a few
+// rounds and checks that they live in the arena, that peak follows them,
+// overflow included, and that a reset gives every byte back for the next
+// round. Run by "make check"; exits with 1 on the first failure.
+//
+//   arenacheck
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../arena.h"
+
+#define ARENACHECK_BYTES (64 * 1024)
+#define ARENACHECK_ROUNDS 3
+#define ARENACHECK_ITEMS 1000         // Fits, with every grown-out buffer left behind.
+#define ARENACHECK_OVERFLOW_ITEMS 20000
+
+#define CHECK(condition)                                                         \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            printf("Arena check FAILED at line %d: %s\n", __LINE__, #condition); \
+            return false;                                                        \
+        }                                                                        \
+    } while (0)
+
+static bool inArena(const Arena* arena, const void* p) {
+    return (const Uint8*)p >= arena->base && (const Uint8*)p < arena->base + arena->size;
+}
+
+// A round's worth of containers, as a caller of the arena would use them.
+static bool checkRound(Arena* arena, const int** firstData) {
+    CHECK(arena->used == 0 && arena->overflowBytes == 0);
+    ArenaResource resource(arena);
+    std::pmr::vector<int> items(&resource);
+    for (int i = 0; i < ARENACHECK_ITEMS; i++)
+        items.push_back(i);
+    CHECK(items[ARENACHECK_ITEMS - 1] == ARENACHECK_ITEMS - 1);
+    CHECK(inArena(arena, items.data()));
+    CHECK(arena->used >= items.capacity() * sizeof(int));
+    CHECK(arena->peak >= arena->used);
+    // The same requests land in the same place every round.
+    if (*firstData == NULL)
+        *firstData = items.data();
+    CHECK(items.data() == *firstData);
+    std::pmr::vector<double> aligned(&resource);
+    aligned.resize(3);
+    CHECK(((size_t)aligned.data() & (alignof(double) - 1)) == 0);
+    return true;
+}
+
+static bool checkOverflow(Arena* arena) {
+    size_t peak = arena->peak;
+    {
+        ArenaResource resource(arena);
+        std::pmr::vector<int> items(&resource);
+        items.resize(ARENACHECK_OVERFLOW_ITEMS);
+        CHECK(!inArena(arena, items.data()));
+        CHECK(arena->overflowBytes >= ARENACHECK_OVERFLOW_ITEMS * sizeof(int));
+        CHECK(arena->peak >= arena->used + arena->overflowBytes && arena->peak > peak);
+    }
+    peak = arena->peak;
+    resetArena(arena);
+    CHECK(arena->used == 0 && arena->overflowBytes == 0 && arena->overflow == NULL);
+    CHECK(arena->peak == peak);
+    return true;
+}
+
+// A NULL arena is the heap, and containers on it free what they drop.
+static bool checkHeap(void) {
+    ArenaResource resource(NULL);
+    std::pmr::vector<int> items(&resource);
+    items.resize(ARENACHECK_OVERFLOW_ITEMS);
+    items.shrink_to_fit();
+    CHECK(items[ARENACHECK_OVERFLOW_ITEMS - 1] == 0);
+    ArenaResource other(NULL);
+    CHECK(resource.is_equal(other));
+    return true;
+}
+
+int main() {
+    Arena arena;
+    if (!initArena(&arena, ARENACHECK_BYTES))
+        return 1;
+    const int* firstData = NULL;
+    bool ok = true;
+    for (int r = 0; ok && r < ARENACHECK_ROUNDS; r++) {
+        ok = checkRound(&arena, &firstData);
+        resetArena(&arena);
+    }
+    ok = ok && checkOverflow(&arena) && checkHeap();
+    size_t peak = arena.peak;
+    freeArena(&arena);
+    if (!ok)
+        return 1;
+    printf("Arena check passed: %d rounds through ArenaResource, peak %zu bytes\n", ARENACHECK_ROUNDS, peak);
+    return 0;
+}
@@ -0,0 +1,115 @@
+// Font baker: renders printable ASCII from a TrueType font and turns it
+// into the signed distance field atlas the game draws all its text from.
+// Glyphs are rendered BAKE_OVERSAMPLE times larger than the field and the
+// distance for each texel is measured on that, so edges stay smooth.
+//
+//   fontbake arial.ttf arial.sdf
+#define SDL_MAIN_HANDLED
+#include <math.h>
+#include <stdio.h>
+#include <SDL_ttf.h>
+#include "../sdf_font.h"
+
+#define BAKE_OVERSAMPLE 4
+
+// Coverage of the oversampled glyph at (x, y); outside the surface is empty.
+static bool covered(const SDL_Surface* glyph, int x, int y) {
+    if (x < 0 || y < 0 || x >= glyph->w || y >= glyph->h)
+        return false;
+    Uint32 pixel = ((const Uint32*)((const Uint8*)glyph->pixels + y * glyph->pitch))[x];
+    return (pixel >> 24) >= 128;
+}
+
+// Fills a cell with the distance from each texel to the nearest edge of the
+// glyph, found by searching the oversampled pixels within the spread.
+static void bakeGlyph(const SDL_Surface* glyph, SdfFont* font, const SdfGlyph* cell) {
+    const int radius = SDF_SPREAD * BAKE_OVERSAMPLE;
+    for (int cy = 0; cy < cell->h; cy++) {
+        for (int cx = 0; cx < cell->w; cx++) {
+            int hx = (cx - SDF_SPREAD) * BAKE_OVERSAMPLE + BAKE_OVERSAMPLE / 2;
+            int hy = (cy - SDF_SPREAD) * BAKE_OVERSAMPLE + BAKE_OVERSAMPLE / 2;
+            bool inside = covered(glyph, hx, hy);
+            int best = radius * radius + 1;
+            for (int dy = -radius; dy <= radius; dy++) {
+                for (int dx = -radius; dx <= radius; dx++) {
+                    int d2 = dx * dx + dy * dy;
+                    if (d2 < best && covered(glyph, hx + dx, hy + dy) != inside)
+                        best = d2;
+                }
+            }
+            // The edge lies half a pixel short of the nearest opposite pixel.
+            float distance = (sqrtf((float)best) - 0.5f) / BAKE_OVERSAMPLE;
+            if (!inside)
+                distance = -distance;
+            float value = 127.5f + distance / SDF_SPREAD * 127.5f;
+            font->pixels[(cell->y + cy) * font->header->atlasWidth + cell->x + cx] =
+                (Uint8)(value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value + 0.5f);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        printf("Usage: %s <font.ttf> <font.sdf>\n", argv[0]);
+        return 1;
+    }
+    if (TTF_Init() == -1) {
+        printf("TTF_Init: %s\n", TTF_GetError());
+        return 1;
+    }
+    TTF_Font* ttf = TTF_OpenFont(argv[1], SDF_BAKE_SIZE * BAKE_OVERSAMPLE);
+    if (!ttf) {
+        printf("Failed to load font %s: %s\n", argv[1], TTF_GetError());
+        TTF_Quit();
+        return 1;
+    }
+    // Render everything first, to know how big the atlas has to be.
+    int fontHeight = TTF_FontHeight(ttf);
+    int cellHeight = (fontHeight + BAKE_OVERSAMPLE - 1) / BAKE_OVERSAMPLE + 2 * SDF_SPREAD;
+    SdfGlyph glyphs[SDF_NUM_CHARS];
+    SDL_Surface* surfaces[SDF_NUM_CHARS];
+    SDL_Color white = {255, 255, 255, 255};
+    int x = 0, y = 0;
+    for (int i = 0; i < SDF_NUM_CHARS; i++) {
+        SdfGlyph* g = &glyphs[i];
+        int minX, maxX, minY, maxY, advance;
+        if (TTF_GlyphMetrics(ttf, (Uint16)(SDF_FIRST_CHAR + i), &minX, &maxX, &minY, &maxY, &advance) < 0)
+            advance = 0;
+        g->advance = (float)advance / BAKE_OVERSAMPLE;
+        surfaces[i] = NULL;
+        SDL_Surface* rendered = TTF_RenderGlyph_Blended(ttf, (Uint16)(SDF_FIRST_CHAR + i), white);
+        if (rendered) {
+            surfaces[i] = SDL_ConvertSurfaceFormat(rendered, SDL_PIXELFORMAT_ARGB8888, 0);
+            SDL_FreeSurface(rendered);
+        }
+        g->w = surfaces[i] ? (surfaces[i]->w + BAKE_OVERSAMPLE - 1) / BAKE_OVERSAMPLE + 2 * SDF_SPREAD : 0;
+        g->h = surfaces[i] ? cellHeight : 0;
+        if (x + g->w > SDF_ATLAS_WIDTH) {
+            x = 0;
+            y += cellHeight;
+        }
+        g->x = x;
+        g->y = y;
+        x += g->w;
+    }
+    SdfFont font;
+    bool ok = allocSdfFont(&font, SDF_ATLAS_WIDTH, y + cellHeight);
+    if (ok) {
+        font.header->lineHeight = (float)fontHeight / BAKE_OVERSAMPLE;
+        for (int i = 0; i < SDF_NUM_CHARS; i++) {
+            font.header->glyphs[i] = glyphs[i];
+            if (surfaces[i])
+                bakeGlyph(surfaces[i], &font, &glyphs[i]);
+        }
+        ok = saveSdfFont(argv[2], &font);
+        if (ok)
+            printf("%s: %dx%d atlas, %u bytes\n", argv[2], font.header->atlasWidth, font.header->atlasHeight,
+                   (unsigned)font.blockSize);
+        freeSdfFont(&font);
+    }
+    for (int i = 0; i < SDF_NUM_CHARS; i++)
+        SDL_FreeSurface(surfaces[i]);
+    TTF_CloseFont(ttf);
+    TTF_Quit();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+// Level compiler: turns the text form of a level into the binary form the
+// game loads with a single read.
+//
+//   levelc levels/level1.txt levels/level1.lvl
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include "../level.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        printf("Usage: %s <level.txt> <level.lvl>\n", argv[0]);
+        return 1;
+    }
+    Level level;
+    if (!loadLevelText(argv[1], &level, NULL))
+        return 1;
+    bool ok = saveLevelBinary(argv[2], &level);
+    if (ok)
+        printf("%s: %d golds, %d rocks, %u bytes\n", argv[2], level.header->numGolds, level.header->numRocks, (unsigned)level.blockSize);
+    freeLevel(&level);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+// Level generator: writes a Poisson-disk level, or estimates the target of
+// an existing one.
+//
+//   levelgen <seed> <depth> <count> <out.lvl|out.txt>   (count 0 = fill)
+//   levelgen --estimate <level>
+#define SDL_MAIN_HANDLED
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../level.h"
+#include "../level_gen.h"
+
+int main(int argc, char* argv[]) {
+    Level level;
+    if (argc == 3 && strcmp(argv[1], "--estimate") == 0) {
+        if (!loadLevel(argv[2], &level, NULL))
+            return 1;
+        printf("%s: target %d, estimated %d\n", argv[2], level.header->target, estimateTargetScore(&level));
+        freeLevel(&level);
+        return 0;
+    }
+    if (argc != 5) {
+        printf("Usage: %s <seed> <depth> <count> <out.lvl|out.txt>\n", argv[0]);
+        printf("       %s --estimate <level>\n", argv[0]);
+        return 1;
+    }
+    LevelGenParams params;
+    params.seed = (Uint32)strtoul(argv[1], NULL, 10);
+    params.width = 1366;
+    params.top = 280;
+    params.height = atoi(argv[2]);
+    params.maxObjects = atoi(argv[3]);
+    params.bandTop = 0;
+    params.bandHeight = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (!generateLevel(&params, &level, NULL)) {
+        printf("Generation failed\n");
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%d golds, %d rocks in %.2f ms, target %d\n", level.header->numGolds, level.header->numRocks, ms, level.header->target);
+    size_t len = strlen(argv[4]);
+    bool ok = len > 4 && strcmp(argv[4] + len - 4, ".lvl") == 0 ? saveLevelBinary(argv[4], &level) : saveLevelText(argv[4], &level);
+    freeLevel(&level);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Live metrics monitor: reads the block a running game publishes in shared
+// memory and prints it once a second. Reading is a plain copy, so watching
+// a cabinet costs the game nothing.
+//
+//   metricsmon [--once]
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <string.h>
+#include "../metrics.h"
+
+static const char* HOOK_NAMES[] = {"swinging", "dropping", "returning", "pulling", "dynamite", "explosion"};
+
+static void printMetrics(const MetricsBlock* m, bool stalled) {
+    Uint32 frames = 0;
+    for (int i = 0; i < METRICS_FRAME_BUCKETS; i++)
+        frames += m->frameHistogram[i];
+    printf("pid %u %s%s  %.1f fps  last frame %.1f ms  rounds %u", m->pid, metricsScreenName(m->screen),
+           stalled ? " (STALLED)" : "", m->fps, m->frameMs, m->roundsPlayed);
+    if (m->screen == SCREEN_SESSION)
+        printf("  level %d score %d hook %s", m->level, m->score, m->hookState < 6 ? HOOK_NAMES[m->hookState] : "?");
+    printf("\n  loads: startup %.0f ms, last round %.0f ms, worst round %.0f ms\n", m->startupLoadMs, m->roundLoadMs,
+           m->roundLoadMaxMs);
+    // Share of frames in each 2 ms bucket, skipping empty ones.
+    printf("  frames:");
+    for (int i = 0; i < METRICS_FRAME_BUCKETS && frames > 0; i++) {
+        if (m->frameHistogram[i] == 0)
+            continue;
+        if (i == METRICS_FRAME_BUCKETS - 1)
+            printf(" %d+ms %.1f%%", i * METRICS_BUCKET_MS, m->frameHistogram[i] * 100.0f / frames);
+        else
+            printf(" %d-%dms %.1f%%", i * METRICS_BUCKET_MS, (i + 1) * METRICS_BUCKET_MS, m->frameHistogram[i] * 100.0f / frames);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    bool once = argc > 1 && strcmp(argv[1], "--once") == 0;
+    const MetricsShared* shared = mapMetrics();
+    if (shared == NULL) {
+        printf("No running game found (%s)\n", METRICS_NAME);
+        return 1;
+    }
+    Uint32 lastUpdate = 0;
+    for (bool first = true;; first = false) {
+        MetricsBlock m;
+        if (!readMetrics(shared, &m)) {
+            printf("Metrics block is being rewritten too often to read\n");
+        } else {
+            // A game that has not published for a whole poll is stuck or gone.
+            printMetrics(&m, !first && m.updatedMs == lastUpdate);
+            lastUpdate = m.updatedMs;
+        }
+        if (once)
+            break;
+        SDL_Delay(1000);
+    }
+    unmapMetrics(shared);
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Soft raster benchmark: draws a scripted playfield (the background, thirty
+// objects, two characters, their hooks and ropes, an explosion) at 1366x768
+// with SDL's software renderer and with the soft raster at each SIMD level,
+// on one thread and on every core, and prints the time per frame and how
+// far each result is from SDL's.
+//
+//   rasterbench [frames]
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL_image.h>
+#include "../game.h"
+#include "../rotated_sprite.h"
+#include "../soft_raster.h"
+
+#define BENCH_WIDTH 1366
+#define BENCH_HEIGHT 768
+#define BENCH_OBJECTS 30
+
+enum { IMAGE_BACKGROUND, IMAGE_GOLD, IMAGE_ROCK, IMAGE_BAG, IMAGE_CHARACTER, IMAGE_EXPLOSION, IMAGE_HOOK, NUM_IMAGES };
+
+static const char* IMAGE_FILES[IMAGE_HOOK] = {
+    "background.png", "gold.png", "rock.png", "mysbag.png", "character.png", "explosion.png",
+};
+
+static SDL_Surface* surfaces[NUM_IMAGES];  // The hook's is the rotated sheet.
+static RasterImage images[NUM_IMAGES];
+static SDL_Texture* textures[NUM_IMAGES];
+static RotatedSprite hook;
+static SDL_Point hookPivot;
+
+static Uint32 nextScript(Uint32* state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// One image through whichever backend is being measured.
+static void drawImage(Raster* raster, SDL_Renderer* renderer, int image, const SDL_Rect* src, const SDL_Rect* dst,
+                      SDL_Color mod) {
+    if (raster) {
+        rasterCopy(raster, &images[image], src, dst, mod);
+        return;
+    }
+    SDL_SetTextureColorMod(textures[image], mod.r, mod.g, mod.b);
+    SDL_SetTextureAlphaMod(textures[image], mod.a);
+    SDL_RenderCopy(renderer, textures[image], src, dst);
+}
+
+// Frame `t` of the script, drawn the way the session loop draws the playfield.
+static void drawFrame(Raster* raster, SDL_Renderer* renderer, int t) {
+    SDL_Color white = {255, 255, 255, 255}, blue = {150, 150, 255, 255};
+    int scroll = t % 40;
+    SDL_Rect bgRect = {0, -scroll, BENCH_WIDTH, BENCH_HEIGHT};
+    drawImage(raster, renderer, IMAGE_BACKGROUND, NULL, &bgRect, white);
+    SDL_Rect deepSrc = {0, surfaces[IMAGE_BACKGROUND]->h * 2 / 3, surfaces[IMAGE_BACKGROUND]->w,
+                        surfaces[IMAGE_BACKGROUND]->h / 3};
+    SDL_Rect deepRect = {0, BENCH_HEIGHT - scroll, BENCH_WIDTH, BENCH_HEIGHT / 3};
+    drawImage(raster, renderer, IMAGE_BACKGROUND, &deepSrc, &deepRect, white);
+    Uint32 script = 7;
+    for (int i = 0; i < BENCH_OBJECTS; i++) {
+        int size = 30 + (int)(nextScript(&script) % 120);
+        SDL_Rect r = {(int)(nextScript(&script) % 1300) - 20, 250 + (int)(nextScript(&script) % 520), size, size};
+        drawImage(raster, renderer, IMAGE_GOLD + i % 3, NULL, &r, white);
+    }
+    for (int p = 0; p < 2; p++) {
+        SDL_Color tint = p ? blue : white;
+        SDL_Rect charRect = {483 + p * 200, 90, 200, 100};
+        drawImage(raster, renderer, IMAGE_CHARACTER, NULL, &charRect, tint);
+        const RotatedFrame* frame = findRotatedFrame(&hook, sinf(t * 0.05f + p) * 75.0f);
+        SDL_Rect hookRect = {560 + p * 200 + frame->offset.x, 250 + frame->offset.y, frame->src.w, frame->src.h};
+        drawImage(raster, renderer, IMAGE_HOOK, &frame->src, &hookRect, tint);
+        int x1 = 583 + p * 200, y1 = 140, x2 = 560 + p * 200, y2 = 250;
+        if (raster) {
+            rasterLine(raster, x1, y1, x2, y2, (SDL_Color){255, 0, 0, 255});
+        } else {
+            SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+            SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+        }
+    }
+    SDL_Rect explosionRect = {900, 400, 100, 100};
+    drawImage(raster, renderer, IMAGE_EXPLOSION, NULL, &explosionRect, (SDL_Color){255, 255, 255, 128});
+    if (raster)
+        flushRaster(raster);
+    else
+        SDL_RenderFlush(renderer);
+}
+
+// Mean difference per colour channel, 0-255.
+static double meanDifference(const SDL_Surface* a, const SDL_Surface* b) {
+    double total = 0.0;
+    for (int y = 0; y < a->h; y++) {
+        const Uint32* ra = (const Uint32*)((const Uint8*)a->pixels + y * a->pitch);
+        const Uint32* rb = (const Uint32*)((const Uint8*)b->pixels + y * b->pitch);
+        for (int x = 0; x < a->w; x++) {
+            for (int shift = 0; shift < 24; shift += 8)
+                total += abs((int)(ra[x] >> shift & 0xFF) - (int)(rb[x] >> shift & 0xFF));
+        }
+    }
+    return total / ((double)a->w * a->h * 3);
+}
+
+static double millisecondsSince(Uint64 start, int frames) {
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency() / frames;
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    if (frames <= 0) {
+        printf("Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+        printf("SDL_image error: %s\n", IMG_GetError());
+        return 1;
+    }
+    bool ok = true;
+    for (int i = 0; i < IMAGE_HOOK && ok; i++) {
+        surfaces[i] = IMG_Load(IMAGE_FILES[i]);
+        if (!surfaces[i]) {
+            printf("Error loading %s: %s\n", IMAGE_FILES[i], IMG_GetError());
+            ok = false;
+        }
+    }
+    int hookW, hookH;
+    hookGeometry(&hookW, &hookH, &hookPivot);
+    SDL_Surface* hookSource = ok ? IMG_Load("hook.png") : NULL;
+    ok = ok && buildRotatedSprite(&hook, hookSource, hookW, hookH, hookPivot);
+    SDL_FreeSurface(hookSource);
+    surfaces[IMAGE_HOOK] = hook.sheet;
+    for (int i = 0; i < NUM_IMAGES && ok; i++)
+        ok = initRasterImage(&images[i], surfaces[i], NULL);
+    SDL_Surface* sdlTarget = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Surface* rasterTarget = SDL_CreateRGBSurfaceWithFormat(0, BENCH_WIDTH, BENCH_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = ok && sdlTarget ? SDL_CreateSoftwareRenderer(sdlTarget) : NULL;
+    for (int i = 0; i < NUM_IMAGES && renderer; i++) {
+        textures[i] = SDL_CreateTextureFromSurface(renderer, surfaces[i]);
+        if (textures[i])
+            SDL_SetTextureBlendMode(textures[i], SDL_BLENDMODE_BLEND);
+    }
+    if (!renderer || !rasterTarget) {
+        printf("Error setting up: %s\n", SDL_GetError());
+        ok = false;
+    }
+    if (ok) {
+        printf("%d frames at %dx%d, %d cores\n", frames, BENCH_WIDTH, BENCH_HEIGHT, SDL_GetCPUCount());
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int t = 0; t < frames; t++)
+            drawFrame(NULL, renderer, t);
+        printf("SDL software     %7.2f ms/frame\n", millisecondsSince(start, frames));
+        const char* simdNames[] = {"scalar", "SSE2", "AVX2"};
+        int threadCounts[] = {1, 0};
+        for (int simd = RASTER_SCALAR; simd <= RASTER_AVX2; simd++) {
+            for (int c = 0; c < 2; c++) {
+                Raster raster;
+                if (!initRaster(&raster, rasterTarget, threadCounts[c]))
+                    break;
+                if (raster.simd < simd) {
+                    freeRaster(&raster);
+                    break;
+                }
+                raster.simd = (RasterSimd)simd;
+                start = SDL_GetPerformanceCounter();
+                for (int t = 0; t < frames; t++)
+                    drawFrame(&raster, NULL, t);
+                // Both targets now hold the last frame, to compare.
+                double ms = millisecondsSince(start, frames);
+                printf("Raster %-6s %2d %7.2f ms/frame, mean difference from SDL %.3f\n", simdNames[simd],
+                       raster.numThreads + 1, ms, meanDifference(sdlTarget, rasterTarget));
+                freeRaster(&raster);
+            }
+        }
+    }
+    for (int i = 0; i < NUM_IMAGES; i++) {
+        if (textures[i])
+            SDL_DestroyTexture(textures[i]);
+        freeRasterImage(&images[i]);
+        if (i != IMAGE_HOOK)
+            SDL_FreeSurface(surfaces[i]);
+    }
+    freeRotatedSprite(&hook);
+    if (renderer)
+        SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(sdlTarget);
+    SDL_FreeSurface(rasterTarget);
+    IMG_Quit();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Tournament replay verifier: plays every replay given (saved by the game
+// with --record, see replay.h) again on every core, checks each claimed
+// result against the one the inputs really make, and lists the files that
+// fail. Exits with 1 if any did.
+//
+//   replaycheck [-j threads] <replay.rep>...
+#define SDL_MAIN_HANDLED
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../level_gen.h"
+#include "../replay.h"
+
+#define CHECK_MAX_THREADS 64
+
+typedef struct {
+    bool tried;
+    bool loaded;
+    Level level;              // Untouched; each replay plays a copy.
+} CachedLevel;
+
+typedef struct {
+    char** paths;
+    int numPaths;
+    SDL_atomic_t next;        // First replay no thread has taken yet.
+    bool* passed;
+    char (*reasons)[REPLAY_REASON_LEN];
+    int numAuthored;          // Levels with a file; the game generates the ones after.
+    SDL_mutex* levelsLock;
+    CachedLevel levels[REPLAY_MAX_LEVEL + 1];  // By level index.
+} Batch;
+
+typedef struct {
+    Batch* batch;
+    SDL_Thread* thread;
+    Uint64 ticks;             // Simulated in the replays that passed.
+} Checker;
+
+// Level `index` as the game would load it, read or generated once for the
+// whole batch. NULL if there is no such level. loadReplay has checked that
+// the index is in range.
+static const Level* findLevel(Batch* batch, Uint32 index) {
+    CachedLevel* cached = &batch->levels[index];
+    SDL_LockMutex(batch->levelsLock);
+    if (!cached->tried) {
+        cached->tried = true;
+        char path[LEVEL_PATH_LEN];
+        if ((int)index > batch->numAuthored)
+            cached->loaded = generateEndlessLevel((int)index, &cached->level, NULL);
+        else if (findLevelFile((int)index, path, sizeof(path)))
+            cached->loaded = loadLevel(path, &cached->level, NULL);
+    }
+    SDL_UnlockMutex(batch->levelsLock);
+    return cached->loaded ? &cached->level : NULL;
+}
+
+// Takes replays off the batch until there are none left. The level copy
+// and the mine go in an arena reset after every replay.
+static int checkWorker(void* data) {
+    Checker* checker = (Checker*)data;
+    Batch* batch = checker->batch;
+    Arena arena;
+    initArena(&arena, SESSION_ARENA_BYTES); // On failure everything overflows to the heap
+    Replay* replay = (Replay*)malloc(sizeof(Replay));
+    if (replay == NULL) {
+        printf("Out of memory\n");
+        freeArena(&arena);
+        return 1;
+    }
+    for (;;) {
+        int i = SDL_AtomicAdd(&batch->next, 1);
+        if (i >= batch->numPaths)
+            break;
+        char* reason = batch->reasons[i];
+        bool ok = loadReplay(batch->paths[i], replay, reason);
+        const Level* level = ok ? findLevel(batch, replay->header.levelIndex) : NULL;
+        Level copy;
+        if (ok && level == NULL) {
+            snprintf(reason, REPLAY_REASON_LEN, "level %u cannot be loaded", replay->header.levelIndex);
+            ok = false;
+        } else if (ok && !copyLevel(level, &copy, &arena)) {
+            snprintf(reason, REPLAY_REASON_LEN, "out of memory");
+            ok = false;
+        }
+        if (ok)
+            ok = verifyReplay(replay, &copy, &arena, reason);
+        if (ok)
+            checker->ticks += replay->header.ticks;
+        batch->passed[i] = ok;
+        resetArena(&arena);
+    }
+    free(replay);
+    freeArena(&arena);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = SDL_GetCPUCount();
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+        threads = atoi(argv[2]);
+        first = 3;
+    }
+    if (first >= argc || threads <= 0) {
+        printf("Usage: %s [-j threads] <replay.rep>...\n", argv[0]);
+        return 1;
+    }
+    static Batch batch; // Static: the level cache is big
+    batch.paths = argv + first;
+    batch.numPaths = argc - first;
+    batch.passed = (bool*)calloc(batch.numPaths, sizeof(bool));
+    batch.reasons = (char(*)[REPLAY_REASON_LEN])calloc(batch.numPaths, REPLAY_REASON_LEN);
+    batch.levelsLock = SDL_CreateMutex();
+    char path[LEVEL_PATH_LEN];
+    while (findLevelFile(batch.numAuthored + 1, path, sizeof(path)))
+        batch.numAuthored++;
+    if (!batch.passed || !batch.reasons || !batch.levelsLock) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    if (threads > CHECK_MAX_THREADS)
+        threads = CHECK_MAX_THREADS;
+    if (threads > batch.numPaths)
+        threads = batch.numPaths;
+    auto start = std::chrono::steady_clock::now();
+    // This thread checks too, alongside the others.
+    static Checker checkers[CHECK_MAX_THREADS];
+    int started = 1;
+    for (int t = 0; t < threads; t++)
+        checkers[t].batch = &batch;
+    for (; started < threads; started++) {
+        checkers[started].thread = SDL_CreateThread(checkWorker, "replaycheck", &checkers[started]);
+        if (!checkers[started].thread) {
+            printf("Thread error: %s\n", SDL_GetError());
+            break;
+        }
+    }
+    checkWorker(&checkers[0]);
+    Uint64 ticks = checkers[0].ticks;
+    for (int t = 1; t < started; t++) {
+        SDL_WaitThread(checkers[t].thread, NULL);
+        ticks += checkers[t].ticks;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    int rejected = 0;
+    for (int i = 0; i < batch.numPaths; i++) {
+        if (!batch.passed[i]) {
+            printf("%s: rejected, %s\n", batch.paths[i], batch.reasons[i]);
+            rejected++;
+        }
+    }
+    double seconds = ms > 0.0 ? ms / 1000.0 : 1e-9;
+    printf("%d replays: %d verified, %d rejected in %.0f ms on %d threads (%.0f replays/s, %.1f M ticks/s)\n",
+           batch.numPaths, batch.numPaths - rejected, rejected, ms, started, batch.numPaths / seconds,
+           ticks / seconds / 1e6);
+    for (int i = 0; i <= REPLAY_MAX_LEVEL; i++) {
+        if (batch.levels[i].loaded)
+            freeLevel(&batch.levels[i].level);
+    }
+    SDL_DestroyMutex(batch.levelsLock);
+    free(batch.passed);
+    free(batch.reasons);
+    return rejected > 0 ? 1 : 0;
+}
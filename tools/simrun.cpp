@@ -0,0 +1,113 @@
+// Headless gameplay workload: plays scripted two-player rounds of every
+// authored level and a few generated ones through the game library, with
+// no window or audio. Used to train profile-guided builds (make pgo) and
+// as a quick simulation benchmark.
+//
+//   simrun [rounds per level]
+#define SDL_MAIN_HANDLED
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../game.h"
+#include "../level_gen.h"
+#include "../particles.h"
+#include "../snapshot.h"
+
+// Generated levels played after the authored ones.
+#define SIMRUN_ENDLESS_LEVELS 3
+
+static SnapshotRing snapshots;
+
+static Uint32 nextScript(Uint32* state) {
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+// One round with both hooks driven by a script: release the hook at a
+// random point of the swing, sometimes blow up what comes back, and go back
+// a second once per round.
+static int playRound(Level* level, Uint32 seed, Particles* particles) {
+    Mine mine;
+    if (!initMine(&mine, level, NULL))
+        return 0;
+    Game game;
+    initGame(&game, level->header, &mine, 2, seed);
+    clearSnapshots(&snapshots);
+    HookState lastStates[MAX_PLAYERS] = {OSCILLATING, OSCILLATING};
+    Uint32 script = seed;
+    bool rewound = false;
+    while (!game.timeUp) {
+        InputAction inputs[MAX_PLAYERS];
+        int n = 0;
+        for (int i = 0; i < game.numPlayers; i++) {
+            Uint32 roll = nextScript(&script);
+            HookState state = game.players[i].hookState;
+            if ((state == OSCILLATING && roll % 40 == 0) || (state == PULLING_GOLD && roll % 200 == 0)) {
+                InputAction* input = &inputs[n++];
+                input->tick = game.tick;
+                input->offset = (Uint8)(roll >> 12);
+                input->kind = state == OSCILLATING ? INPUT_RELEASE : INPUT_DYNAMITE;
+                input->player = (Uint8)i;
+            }
+        }
+        if (game.tick % SNAPSHOT_INTERVAL == 0)
+            pushSnapshot(&snapshots, &game);
+        stepGame(&game, inputs, n);
+        if (!rewound && game.tick == game.tuning->timeLimit * SIM_RATE / 2) {
+            rollbackGame(&snapshots, &game, game.tick - SIM_RATE);
+            rewound = true;
+        }
+        for (int i = 0; i < game.numPlayers; i++) {
+            const PlayerState* p = &game.players[i];
+            if (p->hookState == dynamite_EXPLOSION && lastStates[i] != dynamite_EXPLOSION)
+                spawnExplosion(particles, p->explosionX, p->explosionY);
+            lastStates[i] = p->hookState;
+        }
+        updateParticles(particles, SIM_DT);
+    }
+    int score = game.players[0].score + game.players[1].score;
+    freeMine(&mine);
+    return score;
+}
+
+static void playLevel(Level* level, int index, bool generated, int rounds, Particles* particles) {
+    auto start = std::chrono::steady_clock::now();
+    long long total = 0;
+    for (int r = 0; r < rounds; r++)
+        total += playRound(level, (Uint32)(index * 7919 + r + 1), particles);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double ticks = (double)rounds * level->header->timeLimit * SIM_RATE;
+    printf("Level %d%s: %d rounds, average score %lld, %.2f us per tick\n", index, generated ? " (generated)" : "",
+           rounds, total / rounds, ms * 1000.0 / ticks);
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 4;
+    if (rounds <= 0) {
+        printf("Usage: %s [rounds per level]\n", argv[0]);
+        return 1;
+    }
+    Particles particles;
+    initParticles(&particles);
+    auto start = std::chrono::steady_clock::now();
+    int index = 1;
+    char path[LEVEL_PATH_LEN];
+    Level level;
+    for (; findLevelFile(index, path, sizeof(path)); index++) {
+        if (!loadLevel(path, &level, NULL))
+            return 1;
+        playLevel(&level, index, false, rounds, &particles);
+        freeLevel(&level);
+    }
+    for (int i = 0; i < SIMRUN_ENDLESS_LEVELS; i++, index++) {
+        if (!generateEndlessLevel(index, &level, NULL))
+            return 1;
+        playLevel(&level, index, true, rounds, &particles);
+        freeLevel(&level);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%d levels in %.0f ms\n", index - 1, ms);
+    freeParticles(&particles);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Telemetry decoder: turns the game's binary event logs into CSV, one row
+// per record, for balancing analysis. Files are read in the order given;
+// with none, the rotated logs next to the game are read oldest first.
+// The meaning of detail, a and b for each event is listed in game.h and
+// telemetry.h.
+//
+//   telecsv [telemetry.1.bin telemetry.bin ...] > events.csv
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include "../telemetry.h"
+
+static bool hasObjectKind(int kind) {
+    return kind == GAME_EVENT_GRAB || kind == GAME_EVENT_DYNAMITE || kind == GAME_EVENT_CATCH;
+}
+
+static bool decodeFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error opening %s\n", path);
+        return false;
+    }
+    TelemetryFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TELEMETRY_MAGIC ||
+        header.version != TELEMETRY_VERSION || header.recordSize != sizeof(TelemetryRecord)) {
+        fprintf(stderr, "%s is not a telemetry log this decoder understands\n", path);
+        fclose(file);
+        return false;
+    }
+    TelemetryRecord records[1024];
+    size_t got;
+    while ((got = fread(records, sizeof(TelemetryRecord), 1024, file)) > 0) {
+        for (size_t i = 0; i < got; i++) {
+            const TelemetryRecord* r = &records[i];
+            printf("%u,%u,%s,%d,", r->ms, r->tick, telemetryKindName(r->kind), r->player);
+            if (hasObjectKind(r->kind) && r->detail < NUM_OBJECT_KINDS)
+                printf("%s %s", OBJECT_ARCHETYPES[r->detail].isRock ? "rock" : "gold", OBJECT_ARCHETYPES[r->detail].name);
+            else
+                printf("%d", r->detail);
+            printf(",%d,%d\n", r->a, r->b);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    printf("ms,tick,event,player,detail,a,b\n");
+    bool ok = true;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            ok = decodeFile(argv[i]) && ok;
+        return ok ? 0 : 1;
+    }
+    int found = 0;
+    for (int age = TELEMETRY_KEEP_FILES - 1; age >= 0; age--) {
+        char path[32];
+        if (age == 0)
+            snprintf(path, sizeof(path), "telemetry.bin");
+        else
+            snprintf(path, sizeof(path), "telemetry.%d.bin", age);
+        FILE* probe = fopen(path, "rb");
+        if (probe == NULL)
+            continue;
+        fclose(probe);
+        ok = decodeFile(path) && ok;
+        found++;
+    }
+    if (found == 0) {
+        fprintf(stderr, "Usage: %s [telemetry logs, oldest first]\n", argv[0]);
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#include "triple_buffer.h"
+
+void initTripleBuffer(TripleBuffer* buffer) {
+    buffer->front = 0;
+    buffer->middle.store(1, std::memory_order_relaxed);
+    buffer->back = 2;
+}
+
+// The exchanges release the slot handed over and acquire the one taken,
+// so everything written into a slot is visible to whoever takes it next.
+int publishTripleBuffer(TripleBuffer* buffer) {
+    buffer->back = buffer->middle.exchange(buffer->back | TRIPLE_FRESH, std::memory_order_acq_rel) & ~TRIPLE_FRESH;
+    return buffer->back;
+}
+
+int takeTripleBuffer(TripleBuffer* buffer) {
+    if (buffer->middle.load(std::memory_order_relaxed) & TRIPLE_FRESH)
+        buffer->front = buffer->middle.exchange(buffer->front, std::memory_order_acq_rel) & ~TRIPLE_FRESH;
+    return buffer->front;
+}
@@ -0,0 +1,30 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <stdbool.h>
+
+// Hands whole frames from one writer thread to one reader thread with no
+// lock and no waiting on either side. The caller keeps three slots: the
+// writer fills the back one, the reader draws from the front one, and the
+// middle one holds the newest finished frame. Publishing swaps back and
+// middle; taking swaps middle and front, but only when something was
+// published since, so the reader never goes back to an older frame.
+#define TRIPLE_FRESH 4            // In `middle`: published since the last take.
+
+typedef struct {
+    std::atomic<int> middle;
+    alignas(64) int back;     // Writer's slot.
+    alignas(64) int front;    // Reader's slot.
+} TripleBuffer;
+
+void initTripleBuffer(TripleBuffer* buffer);
+
+// Writer: the back slot is finished. Returns the slot to fill next.
+int publishTripleBuffer(TripleBuffer* buffer);
+
+// Reader: moves on to the newest published slot, if there is one. Returns
+// the slot to read.
+int takeTripleBuffer(TripleBuffer* buffer);
+
+#endif // TRIPLE_BUFFER_H